@@ -0,0 +1,200 @@
+from PIL import Image
+
+import hashlib
+import sys
+
+# Atlas pages are always this wide; their height grows to fit, up to the max.
+PAGE_WIDTH = 256
+MAX_PAGE_HEIGHT = 256
+
+# Transparent gap left ’tween packed sprites so nearest sampling at fractional
+# positions ne’er bleeds a neighbour’s edge into view.
+PADDING = 1
+
+TRANSPARENT_INDEX = 0
+
+# Tile table entries for tiles with no visible pixels, which ne’er get packed.
+EMPTY_TILE = 0xFFFF
+
+def int_to_bytes( value ):
+    return value.to_bytes( 2, byteorder='big' )
+
+def load_image( local_file ):
+    full_filename = "dev/images/" + local_file + ".png"
+    try:
+        image = Image.open( full_filename )
+    except FileNotFoundError:
+        print( "File not found: %s" %( full_filename ) )
+        return None
+
+    if image.format != "PNG":
+        print( "Invalid file format: is %s; must be PNG." %( image.format ) )
+        return None
+
+    if image.getpalette() == None:
+        print( "Invalid file format: missing palette. Must be indexed PNG." )
+        return None
+
+    width, height = image.size
+    rows = []
+    for y in range( height ):
+        rows.append( bytes( image.getpixel(( x, y )) for x in range( width ) ) )
+    return { "name": local_file, "width": width, "height": height, "rows": rows }
+
+# Shrink sprite to the smallest box holding all non-transparent pixels,
+# remembering where that box sat so the game can still place it by its full size.
+def trim( sprite ):
+    rows = sprite[ "rows" ]
+    used_rows = [ y for y in range( sprite[ "height" ] ) if any( i != TRANSPARENT_INDEX for i in rows[ y ] ) ]
+    used_columns = [ x for x in range( sprite[ "width" ] ) if any( row[ x ] != TRANSPARENT_INDEX for row in rows ) ]
+
+    if not used_rows:
+        sprite[ "trim_x" ] = sprite[ "trim_y" ] = sprite[ "trim_width" ] = sprite[ "trim_height" ] = 0
+        sprite[ "pixels" ] = []
+        return
+
+    left = used_columns[ 0 ]
+    right = used_columns[ -1 ] + 1
+    top = used_rows[ 0 ]
+    bottom = used_rows[ -1 ] + 1
+    sprite[ "trim_x" ] = left
+    sprite[ "trim_y" ] = top
+    sprite[ "trim_width" ] = right - left
+    sprite[ "trim_height" ] = bottom - top
+    sprite[ "pixels" ] = [ rows[ y ][ left:right ] for y in range( top, bottom ) ]
+
+# Cut a tileset into a grid o’ tiles, left to right, top to bottom, in source coordinates.
+# Edge tiles are cut short if the image isn’t a whole number o’ tiles.
+def split_tiles( sprite, tile_size ):
+    tiles = []
+    for tile_y in range( 0, sprite[ "height" ], tile_size ):
+        for tile_x in range( 0, sprite[ "width" ], tile_size ):
+            rows = [ sprite[ "rows" ][ y ][ tile_x:tile_x + tile_size ] for y in range( tile_y, min( tile_y + tile_size, sprite[ "height" ] ) ) ]
+            if all( i == TRANSPARENT_INDEX for row in rows for i in row ):
+                tiles.append( None )
+            else:
+                tiles.append( { "name": "%s tile %s,%s" %( sprite[ "name" ], tile_x, tile_y ), "trim_width": len( rows[ 0 ] ), "trim_height": len( rows ), "pixels": rows } )
+    return tiles
+
+# Identical trimmed sprites & tiles share one spot in the atlas: each block is keyed by a hash o’ its size & pixels,
+# & only the first block with a given key gets packed.
+def deduplicate( blocks, unique_blocks ):
+    for index, block in enumerate( blocks ):
+        if block == None or block[ "trim_width" ] == 0:
+            continue
+        hasher = hashlib.sha1()
+        hasher.update( int_to_bytes( block[ "trim_width" ] ) + int_to_bytes( block[ "trim_height" ] ) )
+        for row in block[ "pixels" ]:
+            hasher.update( row )
+        key = hasher.digest()
+        if key not in unique_blocks:
+            unique_blocks[ key ] = block
+        blocks[ index ] = unique_blocks[ key ]
+
+# Simple shelf packer: tallest blocks first, filling rows left to right.
+def pack( blocks ):
+    pages = []
+    page = None
+    order = sorted( blocks, key=lambda s: ( s[ "trim_height" ], s[ "trim_width" ] ), reverse=True )
+
+    for sprite in order:
+        width = sprite[ "trim_width" ]
+        height = sprite[ "trim_height" ]
+
+        if width + PADDING * 2 > PAGE_WIDTH or height + PADDING * 2 > MAX_PAGE_HEIGHT:
+            print( "Sprite %s is too big for a %sx%s atlas page." %( sprite[ "name" ], PAGE_WIDTH, MAX_PAGE_HEIGHT ) )
+            return None
+
+        if page != None and page[ "shelf_x" ] + width + PADDING > PAGE_WIDTH:
+            page[ "shelf_y" ] = page[ "height" ]
+            page[ "shelf_x" ] = PADDING
+
+        if page == None or page[ "shelf_y" ] + height + PADDING > MAX_PAGE_HEIGHT:
+            page = { "shelf_x": PADDING, "shelf_y": PADDING, "height": PADDING, "sprites": [] }
+            pages.append( page )
+
+        sprite[ "page" ] = len( pages ) - 1
+        sprite[ "x" ] = page[ "shelf_x" ]
+        sprite[ "y" ] = page[ "shelf_y" ]
+        page[ "shelf_x" ] += width + PADDING
+        page[ "height" ] = max( page[ "height" ], page[ "shelf_y" ] + height + PADDING )
+        page[ "sprites" ].append( sprite )
+
+    return pages
+
+def page_to_bytes( page ):
+    height = page[ "height" ]
+    pixels = [ bytearray( PAGE_WIDTH ) for y in range( height ) ]
+    for sprite in page[ "sprites" ]:
+        for row_index, row in enumerate( sprite[ "pixels" ] ):
+            y = sprite[ "y" ] + row_index
+            pixels[ y ][ sprite[ "x" ]:sprite[ "x" ] + len( row ) ] = row
+
+    # Rows go bottom-up, same as .jwi files, so pages upload as-is.
+    output_data = bytearray()
+    output_data.extend( int_to_bytes( PAGE_WIDTH ) )
+    output_data.extend( int_to_bytes( height ) )
+    for row in reversed( pixels ):
+        output_data.extend( row )
+    return output_data
+
+# Each argument is an image name, or name:tile_size for a tileset whose tiles should be deduplicated one by one.
+def bake_atlas( atlas_name, arguments ):
+    sprites = []
+    for argument in arguments:
+        local_file, _, tile_size = argument.partition( ":" )
+        sprite = load_image( local_file )
+        if sprite == None:
+            return -1
+        sprite[ "tile_size" ] = int( tile_size ) if tile_size else 0
+        if sprite[ "tile_size" ] > 0:
+            sprite[ "tiles" ] = split_tiles( sprite, sprite[ "tile_size" ] )
+            sprite[ "trim_x" ] = sprite[ "trim_y" ] = 0
+            sprite[ "trim_width" ] = sprite[ "width" ]
+            sprite[ "trim_height" ] = sprite[ "height" ]
+        else:
+            trim( sprite )
+            sprite[ "block" ] = [ sprite ]
+        sprites.append( sprite )
+
+    unique_blocks = {}
+    for sprite in sprites:
+        deduplicate( sprite[ "tiles" ] if sprite[ "tile_size" ] > 0 else sprite[ "block" ], unique_blocks )
+
+    pages = pack( list( unique_blocks.values() ) )
+    if pages == None:
+        return -1
+
+    output_data = bytearray( b"JWA\x02" )
+    output_data.extend( int_to_bytes( len( pages ) ) )
+    output_data.extend( int_to_bytes( len( sprites ) ) )
+    for page in pages:
+        output_data.extend( page_to_bytes( page ) )
+
+    for sprite in sprites:
+        name = sprite[ "name" ].encode( "utf-8" )
+        output_data.append( len( name ) )
+        output_data.extend( name )
+        block = sprite[ "block" ][ 0 ] if sprite[ "tile_size" ] == 0 else None
+        position = [ block[ "page" ], block[ "x" ], block[ "y" ] ] if block != None and block[ "trim_width" ] > 0 else [ 0, 0, 0 ]
+        for value in position + [ sprite[ field ] for field in [ "trim_width", "trim_height", "trim_x", "trim_y", "width", "height", "tile_size" ] ]:
+            output_data.extend( int_to_bytes( value ) )
+        if sprite[ "tile_size" ] > 0:
+            for tile in sprite[ "tiles" ]:
+                for value in [ tile[ "page" ], tile[ "x" ], tile[ "y" ] ] if tile != None else [ EMPTY_TILE, 0, 0 ]:
+                    output_data.extend( int_to_bytes( value ) )
+
+    source_pixels = sum( s[ "width" ] * s[ "height" ] for s in sprites )
+    packed_pixels = sum( b[ "trim_width" ] * b[ "trim_height" ] for b in unique_blocks.values() )
+    number_of_tiles = sum( len( s[ "tiles" ] ) for s in sprites if s[ "tile_size" ] > 0 )
+    print( "%s: %s sprites & %s tiles packed as %s unique blocks on %s pages; kept %s o’ %s pixels." %( atlas_name, len( sprites ), number_of_tiles, len( unique_blocks ), len( pages ), packed_pixels, source_pixels ) )
+
+    f = open( "bin/" + atlas_name + ".jwa", "wb" )
+    f.write( output_data )
+    f.close()
+    return 0
+
+if ( len( sys.argv ) < 3 ):
+    print( "Usage: atlas_baker.py atlas_name image [image ...]" )
+else:
+    bake_atlas( sys.argv[ 1 ], sys.argv[ 2: ] )
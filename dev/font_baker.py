@@ -0,0 +1,159 @@
+import sys
+
+# Bakes a font sheet (.jwi) & its metrics (.jwf). Glyphs are 3 x 5 pixels in 4 x 6 cells.
+GLYPH_WIDTH = 3
+GLYPH_HEIGHT = 5
+CELL_WIDTH = 4
+CELL_HEIGHT = 6
+COLUMNS = 16
+FIRST_CHARACTER = 32
+LAST_CHARACTER = 127
+
+TRANSPARENT_INDEX = 0
+
+# Spaces have no pixels to measure, so they get a fixed width.
+SPACE_WIDTH = 2
+GLYPH_SPACING = 1
+
+# Glyph pixels use colour 1, so the game picks a text colour by palette bank: bank 0 draws colour 1, bank 1 colour 9 & so on.
+GLYPH_INDEX = 1
+
+# Each glyph is 5 rows o’ 3 bits, top row first. Lowercase letters share the uppercase shapes; DEL is a solid
+# cell, for drawing boxes & bars with the same texture as the text.
+GLYPHS = {
+    " ": "000 000 000 000 000",
+    "!": "010 010 010 000 010",
+    "\"": "101 101 000 000 000",
+    "#": "101 111 101 111 101",
+    "$": "011 110 010 011 110",
+    "%": "101 001 010 100 101",
+    "&": "010 101 010 101 011",
+    "'": "010 010 000 000 000",
+    "(": "001 010 010 010 001",
+    ")": "100 010 010 010 100",
+    "*": "000 101 010 101 000",
+    "+": "000 010 111 010 000",
+    ",": "000 000 000 010 100",
+    "-": "000 000 111 000 000",
+    ".": "000 000 000 000 010",
+    "/": "001 001 010 100 100",
+    "0": "111 101 101 101 111",
+    "1": "010 110 010 010 111",
+    "2": "111 001 111 100 111",
+    "3": "111 001 111 001 111",
+    "4": "101 101 111 001 001",
+    "5": "111 100 111 001 111",
+    "6": "111 100 111 101 111",
+    "7": "111 001 001 010 010",
+    "8": "111 101 111 101 111",
+    "9": "111 101 111 001 111",
+    ":": "000 010 000 010 000",
+    ";": "000 010 000 010 100",
+    "<": "001 010 100 010 001",
+    "=": "000 111 000 111 000",
+    ">": "100 010 001 010 100",
+    "?": "111 001 011 000 010",
+    "@": "010 101 111 100 011",
+    "A": "010 101 111 101 101",
+    "B": "110 101 110 101 110",
+    "C": "011 100 100 100 011",
+    "D": "110 101 101 101 110",
+    "E": "111 100 111 100 111",
+    "F": "111 100 111 100 100",
+    "G": "011 100 101 101 011",
+    "H": "101 101 111 101 101",
+    "I": "111 010 010 010 111",
+    "J": "001 001 001 101 010",
+    "K": "101 101 110 101 101",
+    "L": "100 100 100 100 111",
+    "M": "101 111 111 101 101",
+    "N": "110 101 101 101 101",
+    "O": "010 101 101 101 010",
+    "P": "110 101 110 100 100",
+    "Q": "010 101 101 111 011",
+    "R": "110 101 110 101 101",
+    "S": "011 100 010 001 110",
+    "T": "111 010 010 010 010",
+    "U": "101 101 101 101 111",
+    "V": "101 101 101 101 010",
+    "W": "101 101 111 111 101",
+    "X": "101 101 010 101 101",
+    "Y": "101 101 010 010 010",
+    "Z": "111 001 010 100 111",
+    "[": "011 010 010 010 011",
+    "\\": "100 100 010 001 001",
+    "]": "110 010 010 010 110",
+    "^": "010 101 000 000 000",
+    "_": "000 000 000 000 111",
+    "`": "100 010 000 000 000",
+    "{": "011 010 110 010 011",
+    "|": "010 010 010 010 010",
+    "}": "110 010 011 010 110",
+    "~": "000 011 110 000 000",
+}
+
+def int_to_bytes( value ):
+    return value.to_bytes( 2, byteorder='big' )
+
+def get_cell( character ):
+    if character == chr( LAST_CHARACTER ):
+        return [ [ GLYPH_INDEX ] * CELL_WIDTH for y in range( CELL_HEIGHT ) ]
+    rows = GLYPHS[ character.upper() ].split()
+    cell = [ [ TRANSPARENT_INDEX ] * CELL_WIDTH for y in range( CELL_HEIGHT ) ]
+    for y in range( GLYPH_HEIGHT ):
+        for x in range( GLYPH_WIDTH ):
+            if rows[ y ][ x ] == "1":
+                cell[ y ][ x ] = GLYPH_INDEX
+    return cell
+
+# Glyphs are measured to their rightmost pixel so text can be spaced proportionally.
+def get_glyph_width( character, cell ):
+    if character == " ":
+        return SPACE_WIDTH
+    return max( x + 1 for y in range( CELL_HEIGHT ) for x in range( CELL_WIDTH ) if cell[ y ][ x ] != TRANSPARENT_INDEX )
+
+def bake_font( font_name ):
+    number_of_characters = LAST_CHARACTER - FIRST_CHARACTER + 1
+    rows_of_cells = ( number_of_characters + COLUMNS - 1 ) // COLUMNS
+    width = COLUMNS * CELL_WIDTH
+    height = rows_of_cells * CELL_HEIGHT
+    pixels = [ [ TRANSPARENT_INDEX ] * width for y in range( height ) ]
+
+    # Metrics: line height, then each glyph’s rectangle on the sheet & how far it moves the pen.
+    metrics_data = bytearray( b"JWF\x01" )
+    for value in [ CELL_HEIGHT, FIRST_CHARACTER, number_of_characters ]:
+        metrics_data.extend( int_to_bytes( value ) )
+    for character in range( FIRST_CHARACTER, LAST_CHARACTER + 1 ):
+        cell = get_cell( chr( character ) )
+        cell_x = ( ( character - FIRST_CHARACTER ) % COLUMNS ) * CELL_WIDTH
+        cell_y = ( ( character - FIRST_CHARACTER ) // COLUMNS ) * CELL_HEIGHT
+        for y in range( CELL_HEIGHT ):
+            for x in range( CELL_WIDTH ):
+                pixels[ cell_y + y ][ cell_x + x ] = cell[ y ][ x ]
+        glyph_width = get_glyph_width( chr( character ), cell )
+        glyph_height = CELL_HEIGHT if character == LAST_CHARACTER else GLYPH_HEIGHT
+        advance = glyph_width if character == LAST_CHARACTER else glyph_width + GLYPH_SPACING
+        for value in [ cell_x, cell_y, glyph_width, glyph_height, advance ]:
+            metrics_data.extend( int_to_bytes( value ) )
+
+    # Same layout as image_converter.py’s .jwi files: size, then indices from the bottom row up.
+    output_data = bytearray()
+    output_data.extend( int_to_bytes( width ) )
+    output_data.extend( int_to_bytes( height ) )
+    for row in reversed( pixels ):
+        output_data.extend( bytes( row ) )
+
+    f = open( "bin/" + font_name + ".jwi", "wb" )
+    f.write( output_data )
+    f.close()
+
+    f = open( "bin/" + font_name + ".jwf", "wb" )
+    f.write( metrics_data )
+    f.close()
+    print( "%s: %s characters in a %s x %s sheet." %( font_name, number_of_characters, width, height ) )
+    return 0
+
+if ( len( sys.argv ) < 2 ):
+    print( "Usage: font_baker.py font_name" )
+else:
+    bake_font( sys.argv[ 1 ] )
@@ -0,0 +1,67 @@
+from PIL import Image
+
+import sys
+
+PALETTE_COLORS = 256
+
+def int_to_bytes( value ):
+    return value.to_bytes( 2, byteorder='big' )
+
+# Reads an indexed PNG’s PLTE chunk, plus alpha from its tRNS chunk, as a list o’ RGBA colours.
+def load_palette( local_file ):
+    full_filename = "dev/images/" + local_file + ".png"
+    try:
+        image = Image.open( full_filename )
+    except FileNotFoundError:
+        print( "File not found: %s" %( full_filename ) )
+        return None
+
+    if image.format != "PNG":
+        print( "Invalid file format: is %s; must be PNG." %( image.format ) )
+        return None
+
+    palette = image.getpalette()
+
+    if palette == None:
+        print( "Invalid file format: missing palette. Must be indexed PNG." )
+        return None
+
+    number_of_colors = min( len( palette ) // 3, PALETTE_COLORS )
+    transparency = image.info.get( "transparency" )
+    colors = []
+    for index in range( number_of_colors ):
+        if isinstance( transparency, bytes ):
+            alpha = transparency[ index ] if index < len( transparency ) else 255
+        else:
+            alpha = 0 if index == transparency else 255
+        colors.append( bytes( palette[ index * 3:index * 3 + 3 ] ) + bytes( [ alpha ] ) )
+
+    # Trailing fully transparent black entries are what the game fills unused colours with anyway.
+    while colors and colors[ -1 ] == bytes( 4 ):
+        colors.pop()
+    return colors
+
+def convert_palettes( pack_name, local_files ):
+    output_data = bytearray( b"JWP\x01" )
+    output_data.extend( int_to_bytes( len( local_files ) ) )
+    for local_file in local_files:
+        colors = load_palette( local_file )
+        if colors == None:
+            return -1
+
+        name = local_file.encode( "utf-8" )
+        output_data.append( len( name ) )
+        output_data.extend( name )
+        output_data.extend( int_to_bytes( len( colors ) ) )
+        for color in colors:
+            output_data.extend( color )
+
+    f = open( "bin/" + pack_name + ".jwp", "wb" )
+    f.write( output_data )
+    f.close()
+    return 0
+
+if ( len( sys.argv ) < 3 ):
+    print( "Usage: palette_converter.py pack_name image [image ...]" )
+else:
+    convert_palettes( sys.argv[ 1 ], sys.argv[ 2: ] )
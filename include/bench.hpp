@@ -0,0 +1,15 @@
+#pragma once
+
+#include "config.hpp"
+
+// Sprite throughput benchmarks, built & run by `make bench`: each scenario draws the same sprites every frame
+// through each submission path it can use, & reports sprites submitted per ms o’ CPU time from render_start to
+// the end o’ render_present, along with draw calls per frame. Results go to obj/bench/results.csv & .json.
+// `make bench BASELINE=file.csv` compares against a saved results.csv, scenario by scenario.
+//
+// Benchmarks build on the null GL backend, so they time render.cpp & not the driver; `make bench REAL_GL=1`
+// builds against GL & times both.
+#if CONFIG_BENCH
+// Returns 0, or -1 if the assets wouldn’t load or the results couldn’t be written.
+int bench_run( const char* baseline_filename );
+#endif
@@ -1,6 +1,51 @@
 #pragma once
 
 #define CONFIG_SHOW_OPENGL_INIT_INFO ( true )
+#define CONFIG_SHOW_MEMORY_REPORT ( true )
+#define CONFIG_SHOW_SHADER_REPORT ( true )
+
+// 0: no GL error checks. 1: driver debug messages, logged asynchronously. 2: glGetError after every ogl_call, plus
+// debug messages delivered synchronously; slow, only for debugging sessions.
+#define CONFIG_OGL_ERROR_LEVEL ( 1 )
+
+// Times render passes on the GPU with timestamp queries, read back a few frames later so nothing stalls.
+#define CONFIG_GPU_TIMERS ( false )
+#define CONFIG_GPU_TIMER_WINDOW ( 60 )
+
+// CPU zone profiler; at exit the last CONFIG_PROFILER_EXPORT_FRAMES frames are written to bin/trace.json.
+#define CONFIG_PROFILER ( false )
+#define CONFIG_PROFILER_EXPORT_FRAMES ( 120 )
+
+// Histograms o’ every frame’s CPU, present-to-present &, with GPU timers, GPU time; printed at exit & on F4.
+#define CONFIG_FRAME_HISTOGRAM ( true )
+
+// Performance overlay shown from startup; F3 toggles it either way.
+#define CONFIG_SHOW_HUD ( false )
+
+// Set by `make NULL_GL=1`, which swaps GL & GLFW for stubs; see null_gl.hpp.
+#ifndef CONFIG_NULL_GL
+#define CONFIG_NULL_GL ( false )
+#endif
+#define CONFIG_NULL_GL_FRAMES ( 600 )
+
+// Set by `make SOFTWARE_RENDERER=1`: every draw is also rasterized on the CPU, see soft_render.hpp. Textures
+// keep CPU copies o’ their indices for it. 0 threads means one per core.
+#ifndef CONFIG_SOFTWARE_RENDERER
+#define CONFIG_SOFTWARE_RENDERER ( false )
+#endif
+#define CONFIG_SOFTWARE_RENDERER_THREADS ( 0 )
+
+// Set by `make golden`, which builds bin/golden to run the golden-image tests ’stead o’ the game; see golden.hpp.
+#ifndef CONFIG_GOLDEN
+#define CONFIG_GOLDEN ( false )
+#endif
+
+// Set by `make bench`, which builds bin/bench to run the sprite benchmarks ’stead o’ the game; see bench.hpp.
+#ifndef CONFIG_BENCH
+#define CONFIG_BENCH ( false )
+#endif
 
 #define CONFIG_WINDOW_WIDTH_PIXELS ( 400 )
-#define CONFIG_WINDOW_HEIGHT_PIXELS ( 224 )
\ No newline at end of file
+#define CONFIG_WINDOW_HEIGHT_PIXELS ( 224 )
+
+#define CONFIG_INDEXED_FRAMEBUFFER ( false )
\ No newline at end of file
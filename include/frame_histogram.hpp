@@ -0,0 +1,42 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+
+// Every frame’s times, kept in log-linear histograms like HdrHistogram’s: exact to the microsecond below 128 µs &
+// within 1/64 o’ the value above, from 1 µs to over an hour, in a fixed 14 KB per clock. Nothing’s averaged away,
+// so the rare long frame players feel shows up in the high percentiles, max & hitch counts.
+//
+// render_present records CPU time (render_start till the buffer swap) & present-to-present time; GPU frame time is
+// recorded as gpu_timer reads each frame back, so only with CONFIG_GPU_TIMERS & a few frames late.
+enum FrameClock
+{
+    FRAME_CLOCK_CPU,
+    FRAME_CLOCK_PRESENT,
+    FRAME_CLOCK_GPU,
+    FRAME_CLOCK_COUNT
+};
+
+// Percentiles are the top o’ the bucket they fall in, so they never read low. Hitches are frames over a 60 FPS
+// or a 30 FPS budget.
+struct FrameHistogramSummary
+{
+    uint64_t frames;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+    uint64_t hitches_over_16ms;
+    uint64_t hitches_over_33ms;
+};
+
+#if CONFIG_FRAME_HISTOGRAM
+void frame_histogram_record( FrameClock clock, double ms );
+double frame_histogram_get_percentile( FrameClock clock, double percentile );
+FrameHistogramSummary frame_histogram_get_summary( FrameClock clock );
+const char* frame_histogram_get_clock_name( FrameClock clock );
+
+// Starts every clock over, such as after a level load that shouldn’t count.
+void frame_histogram_reset();
+void frame_histogram_print_report();
+#endif
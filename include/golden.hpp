@@ -0,0 +1,17 @@
+#pragma once
+
+#include "config.hpp"
+
+// Golden-image tests, built & run by `make golden`: scripted scenes o’ the bin/ assets are drawn headless with
+// the null GL backend, & every few frames the software renderer’s palette indices are checked pixel for pixel
+// against the references in tests/golden/, one PGM per scene with its captured frames stacked top to bottom.
+// Each scene’s CPU time per frame is printed & kept in obj/golden/times.csv, so the next run can show what a
+// change did to it. `make golden UPDATE=1` rewrites the references ’stead o’ checking them.
+#if CONFIG_GOLDEN
+#if !CONFIG_SOFTWARE_RENDERER
+#error "Golden-image tests need the software renderer; build with `make golden`."
+#endif
+
+// Returns how many scenes failed, or -1 if the assets wouldn’t load.
+int golden_run( bool update );
+#endif
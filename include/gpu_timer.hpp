@@ -0,0 +1,48 @@
+#pragma once
+
+#include "config.hpp"
+
+// Passes timed on the GPU. A pass can be timed several times a frame; its frame time is the sum. Beginning a pass
+// that’s already running carries it on, & a pass runs till it’s ended, another pass besides the frame begins, or
+// the frame ends, so a run o’ rects or sprite batches costs one pair o’ timestamp queries ’stead o’ one per draw.
+enum GpuPass
+{
+    GPU_PASS_FRAME,
+    GPU_PASS_RECTS,
+    GPU_PASS_SPRITES,
+    GPU_PASS_RESOLVE,
+    GPU_PASS_COUNT
+};
+
+struct GpuPassStats
+{
+    double last_ms;
+    double average_ms;
+    double max_ms;
+    int frames;
+};
+
+// Everything compiles away without CONFIG_GPU_TIMERS, so timing calls can stay in hot paths.
+#if CONFIG_GPU_TIMERS
+#define GPU_TIMER_INIT() gpu_timer_init()
+#define GPU_TIMER_BEGIN_FRAME() gpu_timer_begin_frame()
+#define GPU_TIMER_BEGIN( pass ) gpu_timer_begin( pass )
+#define GPU_TIMER_END( pass ) gpu_timer_end( pass )
+
+void gpu_timer_init();
+
+// Reads back the results o’ the frame a few frames ago, if the GPU has them yet, & starts recording a new frame.
+void gpu_timer_begin_frame();
+void gpu_timer_begin( GpuPass pass );
+void gpu_timer_end( GpuPass pass );
+
+// Last frame read back, plus average & max over the last CONFIG_GPU_TIMER_WINDOW frames read back.
+GpuPassStats gpu_timer_get_stats( GpuPass pass );
+const char* gpu_timer_get_pass_name( GpuPass pass );
+void gpu_timer_print_report();
+#else
+#define GPU_TIMER_INIT()
+#define GPU_TIMER_BEGIN_FRAME()
+#define GPU_TIMER_BEGIN( pass )
+#define GPU_TIMER_END( pass )
+#endif
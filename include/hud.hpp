@@ -0,0 +1,12 @@
+#pragma once
+
+// Performance overlay for testers: a frame time graph, median & 99th percentile frame times & the last frame’s
+// render stats in the canvas’ top-left corner. Everything’s drawn from one font sheet through the sprite batch,
+// so showing it costs ’bout one draw call.
+bool hud_init();
+void hud_set_visible( bool visible );
+void hud_toggle();
+bool hud_is_visible();
+
+// Counts the time since its last call as a frame, then draws the overlay if it’s showing. Call once a frame, ’fore render_present.
+void hud_draw();
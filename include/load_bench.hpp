@@ -0,0 +1,17 @@
+#pragma once
+
+#include "config.hpp"
+
+// Asset loading benchmark, built & run by `make loadbench`: writes a synthetic corpus o’ .jwi images, from small
+// sprites to large backgrounds, to obj/bench/corpus/, then loads it through render_get_texture twice: once after
+// asking the OS to drop the files from its page cache (cold), & once with them cached (warm). A plain
+// open/read/close o’ each file gives the I/O floor to compare against (read_only). Each size class reports MB/s,
+// per-file latency, read syscalls from /proc/self/io, & the read, decode & upload split from
+// render_get_load_stats. Results go to obj/bench/loading.csv & .json, & `make loadbench BASELINE=file.csv`
+// compares MB/s against an earlier loading.csv.
+//
+// Like `make bench`, this builds on the null GL backend unless REAL_GL=1, so uploads only cost something with GL.
+#if CONFIG_BENCH
+// Returns 0, or -1 if the corpus couldn’t be written or the results couldn’t be saved.
+int load_bench_run( const char* baseline_filename );
+#endif
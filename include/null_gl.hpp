@@ -0,0 +1,35 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+
+// With CONFIG_NULL_GL (`make NULL_GL=1`), GL & the few GLFW calls the engine makes are stubbed out, so the
+// renderer’s CPU side runs & can be measured on machines with no GPU or display. GL calls are counted & the
+// latest recorded; uploads are counted in bytes but go nowhere. Shaders always compile, & their uniforms are
+// found by scanning the source. The window closes itself after CONFIG_NULL_GL_FRAMES frames.
+#if CONFIG_NULL_GL
+struct NullGlStats
+{
+    uint64_t calls;
+    uint64_t draw_calls;
+    uint64_t texture_bytes;
+    uint64_t buffer_bytes;
+    uint64_t frames;
+};
+
+// A recorded call: which function, & its first integer argument where it has one.
+struct NullGlRecord
+{
+    int function;
+    unsigned int argument;
+};
+
+void* null_gl_get_proc_address( const char* name );
+NullGlStats null_gl_get_stats();
+void null_gl_reset_stats();
+
+// Copies up to max_records o’ the latest calls, oldest first, & returns how many were copied.
+int null_gl_get_recording( NullGlRecord* records, int max_records );
+const char* null_gl_get_function_name( int function );
+void null_gl_print_report();
+#endif
@@ -1,11 +1,29 @@
 #pragma once
 
+#include "config.hpp"
+
+// Values for CONFIG_OGL_ERROR_LEVEL.
+#define OGL_ERRORS_OFF 0
+#define OGL_ERRORS_CALLBACK 1
+#define OGL_ERRORS_SYNCHRONOUS 2
+
 #define dassert( x ) if ( !( x ) ) __builtin_trap();
+
+// glGetError ’round every call makes the CPU wait on the driver, so it’s only for debugging sessions.
+#if CONFIG_OGL_ERROR_LEVEL == OGL_ERRORS_SYNCHRONOUS
 #define ogl_call( x ) ogl_clear_error();\
     x;\
     dassert( ogl_log_call( #x, __FILE__, __LINE__ ) )
+#else
+#define ogl_call( x ) x
+#endif
 
 void ogl_clear_error();
 bool ogl_log_call( const char* function, const char* file, int line );
 
-void ogl_check_error();
\ No newline at end of file
+void ogl_check_error();
+
+// Hooks up the driver’s debug output, if there is any & the error level wants it. Messages can arrive on any
+// thread, so they’re queued & only printed by ogl_flush_debug_messages, once a frame on the main thread.
+void ogl_init_debug_output();
+void ogl_flush_debug_messages();
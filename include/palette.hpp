@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+
+#define PALETTE_COLORS 256
+#define PALETTE_ROWS 64
+#define PALETTE_BANK_COLORS 8
+#define PALETTE_BANKS ( PALETTE_COLORS / PALETTE_BANK_COLORS )
+#define CHANNELS_PER_COLOR 4
+#define PALETTE_ROW_SIZE ( PALETTE_COLORS * CHANNELS_PER_COLOR )
+
+// Sprites pick their colours with a palette ID: a palette row, plus which bank o’ 8 colours
+// within that row to shift their indices by. IDs below PALETTE_BANKS are banks o’ row 0.
+#define palette_make_id( row, bank ) ( ( row ) * PALETTE_BANKS + ( bank ) )
+#define palette_id_row( id ) ( ( id ) / PALETTE_BANKS )
+#define palette_id_bank( id ) ( ( id ) % PALETTE_BANKS )
+
+// Per-channel lookup tables for palette-wide colour transforms such as tints, brightness or gamma.
+struct PaletteLUT
+{
+    unsigned char r[ PALETTE_COLORS ];
+    unsigned char g[ PALETTE_COLORS ];
+    unsigned char b[ PALETTE_COLORS ];
+};
+
+void palette_init();
+
+// Palettes load into consecutive rows from .jwp packs (see dev/palette_converter.py) or straight from an indexed
+// PNG’s PLTE & tRNS chunks, & stay resident under their names. The first palette loaded lands in row 0.
+int palette_load( const char* name );
+int palette_load_png( const char* name, const char* filename );
+int palette_add_row( const char* name, const unsigned char* colors );
+int palette_get_row( const char* name );
+
+void palette_set_row( int row, const unsigned char* colors );
+void palette_set_colors( int row, int first, int count, const unsigned char* colors );
+const unsigned char* palette_get_color( int row, int index );
+void palette_upload_dirty_rows();
+
+// Bytes o’ palette colours sent to the GPU since startup.
+size_t palette_get_bytes_uploaded();
+
+// Animations change palette colours in place, so everything drawn with them changes without redrawing.
+// Cycles rotate a range o’ colours by one every frames_per_step frames; keyframes copy each o’ a list
+// o’ colour sets into the range in turn. Both return an ID for palette_remove_animation, or -1 if full.
+int palette_add_cycle( int row, int first, int count, int frames_per_step, bool backward = false );
+int palette_add_keyframes( int row, int first, int count, const unsigned char* keyframes, int number_of_keyframes, int frames_per_keyframe );
+void palette_remove_animation( int animation );
+void palette_update();
+
+// Effects read an untouched base row & write the result into the row sprites are drawn with, so a screen-wide
+// fade costs one pass o’ 256 colours & one row upload no matter how many sprites use it. amount runs 0–255.
+void palette_fade( int dest_row, int source_row, const unsigned char* target_color, int amount );
+void palette_blend( int dest_row, int row_a, int row_b, int amount );
+void palette_make_fade_lut( PaletteLUT* lut, const unsigned char* target_color, int amount );
+void palette_apply_lut( int dest_row, int source_row, const PaletteLUT* lut );
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+
+// Scoped CPU timing zones, recorded per thread & exportable as Chrome trace_event JSON (chrome://tracing, Perfetto).
+// Everything compiles away without CONFIG_PROFILER.
+#if CONFIG_PROFILER
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#define PROFILE_ZONE( name ) ProfileZone PROFILE_CONCAT( profile_zone_, __LINE__ )( name )
+#define PROFILE_FRAME() profiler_mark_frame()
+
+uint64_t profiler_now();
+
+// name must outlive the profiler, which string literals do.
+void profiler_record( const char* name, uint64_t begin, uint64_t end );
+void profiler_mark_frame();
+
+// Writes zones from the last frames, or everything still in the rings if frames is 0. Returns false if the file can’t be written.
+bool profiler_export_chrome_trace( const char* filename, int frames );
+
+// Records from its construction to the end o’ its scope.
+struct ProfileZone
+{
+    const char* name;
+    uint64_t begin;
+
+    explicit ProfileZone( const char* zone_name ) : name( zone_name ), begin( profiler_now() ) {}
+    ~ProfileZone() { profiler_record( name, begin, profiler_now() ); }
+    ProfileZone( const ProfileZone& ) = delete;
+    ProfileZone& operator=( const ProfileZone& ) = delete;
+};
+#else
+#define PROFILE_ZONE( name )
+#define PROFILE_FRAME()
+#endif
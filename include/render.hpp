@@ -1,17 +1,88 @@
 #pragma once
 
+#include <cstddef>
+#include "rect.hpp"
 #include "texture.hpp"
 
-class Rect;
 class RectGFX;
 
+// A region o’ a texture & where its top-left corner goes, relative to the run it’s part of.
+struct SpritePiece
+{
+    Rect src;
+    float x;
+    float y;
+};
+
 void render_texture( Texture texture, const Rect& src, const Rect& dest, int palette, bool flip_x = false, bool flip_y = false, float rotation = 0.0f, float alpha = 1.0f, float rotation_origin_x = 0.0f, float rotation_origin_y = 0.0f );
+
+// Draws a run o’ unscaled, unrotated pieces o’ one texture offset by x, y, such as the glyphs o’ a string,
+// straight into the sprite batch.
+void render_texture_pieces( Texture texture, const SpritePiece* pieces, int count, float x, float y, int palette );
 void render_rect( const Rect& rect, int color );
 
-Texture render_get_texture( const char* name );
+// Textures are loaded once & found by name after, atlas sprites included. Only CPU-readable ones keep the palette
+// indices render_get_texture_pixel reads. Asking for an image that’s already loaded CPU-readable re-reads it to
+// keep them; an atlas sprite can only be made so by loading its whole atlas CPU-readable, so asking for one that
+// wasn’t returns -1.
+Texture render_get_texture( const char* name, bool cpu_readable = false );
+bool render_load_atlas( const char* name, bool cpu_readable = false );
+int render_get_texture_pixel( Texture texture, int x, int y );
+void render_print_memory_report();
+
+// What the last presented frame cost. Counting runs from the end o’ one frame to the end o’ the next, so
+// anything loaded ’tween frames is charged to the frame after it. Culled sprites were wholly off the canvas
+// or clipped away, & ne’er reached a batch. Submit time is CPU time from render_start till the buffer swap.
+struct RenderStats
+{
+    int draw_calls;
+    int batches;
+    int sprites_submitted;
+    int sprites_culled;
+    int state_changes;
+    int state_changes_skipped;
+    size_t texture_bytes_uploaded;
+    size_t vertex_bytes_uploaded;
+    size_t uniform_bytes_uploaded;
+    size_t texture_bytes_resident;
+    double cpu_submit_ms;
+};
+
+RenderStats render_get_stats();
+
+// Totals for every texture & atlas loaded from disk since startup. Reading is opening the file & pulling it into
+// memory, uploading is the glTexImage2D calls, & decoding everything ’tween, such as checking headers & keeping
+// CPU copies. Images found already loaded cost nothing & aren’t counted.
+struct RenderLoadStats
+{
+    int files;
+    size_t bytes_read;
+    double read_ms;
+    double decode_ms;
+    double upload_ms;
+};
+
+RenderLoadStats render_get_load_stats();
 
 bool render_init_window();
 int render_window_closed();
 void render_present();
 void render_start();
-void render_init_gfx();
\ No newline at end of file
+void render_init_gfx();
+
+// Optionally render the whole scene as palette indices at native resolution, resolved to colour through one
+// palette row when presented. Alpha becomes a 50% cutoff in this mode. Takes effect at the next render_start.
+void render_set_indexed_framebuffer( bool enabled );
+void render_set_resolve_palette( int row );
+
+// Caps how many sprites share a draw call, up to the usual limit o’ 2048; 1 draws every sprite on its own, for
+// measuring what batching saves.
+void render_set_batch_limit( int sprites );
+
+// Per-scanline raster effects, by canvas line from the top. A line’s palette row overrides the rows sprites &
+// rects ask for (-1 leaves them be). Offsets & affine transforms shift whole lines o’ the finished frame, so
+// they only show in indexed framebuffer mode. Changes are uploaded together at the next render_start.
+void render_set_scanline_palette( int first_line, int count, int row );
+void render_set_scanline_offset( int line, float x, float y );
+void render_set_scanline_affine( int line, float a, float b, float c, float d );
+void render_reset_scanlines();
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Uniform & attribute names are looked up by 32-bit FNV-1a hash; SHADER_NAME hashes a literal at compile time.
+#define SHADER_NAME( name ) ( std::integral_constant<uint32_t, shader_hash_name( name )>::value )
+
+constexpr uint32_t shader_hash_name( const char* name )
+{
+    uint32_t hash = 0x811C9DC5u;
+    for ( ; *name != '\0'; ++name )
+    {
+        hash = ( hash ^ ( unsigned char )( *name ) ) * 0x01000193u;
+    }
+    return hash;
+}
+
+// Starts linking a program from vertex & fragment source & returns its id without waiting on the driver.
+// If the driver supports program binaries, a binary cached on disk from the same source & driver is loaded
+// ’stead o’ compiling. Returns 0 if there’s no room for another program.
+unsigned int shader_create_program( const char* vertex_shader_code, const char* fragment_shader_code );
+
+// Whether shader_finish_program would return without waiting. Always true without parallel compiles,
+// since there’s no asking the driver then.
+bool shader_program_ready( unsigned int program );
+
+// Waits for a program to link, reports errors & caches its binary. Needed ’fore setting uniforms or drawing.
+bool shader_finish_program( unsigned int program );
+
+// After a program finishes, its active uniforms, attributes & uniform blocks are read into a small table.
+// Lookups return -1 for names the program doesn’t use, same as GL, & setters quietly skip them.
+int shader_get_uniform_location( unsigned int program, uint32_t name );
+int shader_get_attribute_location( unsigned int program, uint32_t name );
+int shader_get_uniform_block_index( unsigned int program, uint32_t name );
+
+// Setters remember the last value written to each uniform & skip writing it again. They bind the program if needed.
+void shader_use_program( unsigned int program );
+void shader_set_int( unsigned int program, uint32_t name, int value );
+void shader_set_float( unsigned int program, uint32_t name, float value );
+void shader_set_vec4( unsigned int program, uint32_t name, float x, float y, float z, float w );
+void shader_set_mat4( unsigned int program, uint32_t name, const float* value );
+
+// Running totals since startup o’ the GL calls the setters made & the ones they skipped.
+struct ShaderStats
+{
+    unsigned int program_binds;
+    unsigned int program_binds_skipped;
+    unsigned int uniform_writes;
+    unsigned int uniform_writes_skipped;
+    size_t uniform_bytes;
+};
+
+ShaderStats shader_get_stats();
+bool shader_can_compile_in_parallel();
+void shader_init();
+void shader_print_report();
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "rect.hpp"
+
+// A CPU rasterizer that draws what the GL path draws in indexed framebuffer mode: palette indices at native
+// resolution, sprites shifted by their palette bank, alpha as a 50% cutoff against the palette’s alpha, &
+// per-line palette rows deciding which alpha that is. With CONFIG_SOFTWARE_RENDERER, render.cpp hands it every
+// sprite quad & rect it draws, so it needs no GL at all, & with `make NULL_GL=1` runs entirely headless.
+//
+// Draws are queued & rasterized when a frame ends, or the queue fills, ’cross tiles o’ the screen shared out
+// among worker threads; each tile replays the queue in order, so overlapping draws land as they do on the GPU.
+
+// A page o’ palette indices, bottom row first like the GL textures made from it.
+struct SoftRenderPage
+{
+    const unsigned char* indices;
+    int width;
+    int height;
+};
+
+// A corner o’ a sprite quad in canvas pixels, with its texture coordinates on the page. Corners go clockwise
+// from the top-left o’ the source, & the quad must be a parallelogram, as flips & rotations leave it.
+struct SoftRenderCorner
+{
+    float x;
+    float y;
+    float u;
+    float v;
+};
+
+// 0 threads means one per core.
+void soft_render_init( int threads );
+void soft_render_close();
+
+// Takes a copy o’ the palette’s alphas, which hold till the next frame like the GPU’s copy.
+void soft_render_start();
+void soft_render_sprite( const SoftRenderPage& page, const SoftRenderCorner* corners, float alpha, int palette_row, int palette_offset );
+void soft_render_rect( const Rect& rect, int color );
+void soft_render_present();
+
+// Same as the scanline table render.cpp uploads: a palette row override (-1 for none), an offset & a 2 x 2
+// transform ’round the screen’s centre, the last two only applied by soft_render_resolve.
+void soft_render_set_scanline( int line, int palette_row, float x, float y, float a, float b, float c, float d );
+
+// The last presented frame’s indices, top row first, CONFIG_WINDOW_WIDTH_PIXELS to a row.
+const unsigned char* soft_render_get_indices();
+
+// Turns the last frame into RGB, 3 bytes a pixel, top row first, as the resolve pass would; index 0 is background.
+void soft_render_resolve( unsigned char* rgb, int palette_row, const unsigned char* background );
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "rect.hpp"
+#include "texture.hpp"
+
+typedef int Font;
+
+// Fonts are a sheet o’ glyphs as an indexed .jwi plus a .jwf o’ metrics, both from dev/font_baker.py.
+// Returns -1 if either file won’t load.
+Font text_load_font( const char* name );
+
+// Draws a string with its top-left corner at x, y, in the colours o’ a palette ID; glyphs drawn in colour 1
+// take colour 1 o’ the ID’s bank. Layouts are cached by string, so text that repeats frame to frame is only
+// measured once, & every glyph goes into the sprite batch in one go. '\n' starts a new line.
+void text_draw( Font font, const char* text, float x, float y, int palette );
+int text_get_width( Font font, const char* text );
+int text_get_height( Font font, const char* text );
+int text_get_line_height( Font font );
+
+// For drawing boxes & such with the same texture as the text, so they share its batch.
+Texture text_get_texture( Font font );
+Rect text_get_glyph( Font font, int character );
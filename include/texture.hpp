@@ -2,4 +2,4 @@
 
 #include <cstdint>
 
-typedef int_fast8_t Texture;
\ No newline at end of file
+typedef int_fast16_t Texture;
\ No newline at end of file
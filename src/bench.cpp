@@ -0,0 +1,348 @@
+#include "config.hpp"
+#include "bench.hpp"
+
+#if CONFIG_BENCH
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "palette.hpp"
+#include "rect.hpp"
+#include "render.hpp"
+
+#define BENCH_SPRITES 10000
+#define BENCH_WARMUP_FRAMES 3
+#define BENCH_MIN_FRAMES 20
+#define BENCH_MIN_MS 250.0
+#define BENCH_SPRITE_SIZE 16.0f
+#define BENCH_TEXTURES 3
+#define MAX_BENCH_RESULTS 64
+#define MAX_BENCH_NAME 63
+#define MAX_FILENAME 255
+#if CONFIG_NULL_GL
+#define BENCH_BACKEND "null_gl"
+#define BENCH_OUTPUT_DIRECTORY "obj/bench/"
+#else
+#define BENCH_BACKEND "gl"
+#define BENCH_OUTPUT_DIRECTORY "obj/bench-gl/"
+#endif
+
+// Scenarios vary one thing at a time from a field o’ unscaled, unrotated sprites o’ one atlas sprite.
+// Moving sprites drift by frame; rect_every puts a rect ’fore every that many sprites, which ends the batch.
+struct BenchScenario
+{
+    const char* name;
+    bool moving;
+    bool rotated;
+    bool many_textures;
+    bool palettes;
+    int rect_every;
+};
+
+// per_call: render_texture with a batch limit o’ 1, so a draw call per sprite. batched: render_texture, batched as
+// usual. pieces: one render_texture_pieces call a frame, for scenarios that are a single run o’ unrotated sprites
+// o’ one texture. There’s no instanced path; sprites go to the GPU as 4 vertices each.
+enum BenchPath
+{
+    BENCH_PATH_PER_CALL,
+    BENCH_PATH_BATCHED,
+    BENCH_PATH_PIECES,
+    NUMBER_OF_BENCH_PATHS
+};
+
+struct BenchResult
+{
+    char scenario[ MAX_BENCH_NAME + 1 ];
+    char path[ MAX_BENCH_NAME + 1 ];
+    int sprites;
+    int frames;
+    double ms_per_frame;
+    double sprites_per_ms;
+    double draw_calls_per_frame;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static bool bench_path_fits( const BenchScenario& scenario, BenchPath path );
+static void bench_draw( const BenchScenario& scenario, BenchPath path, int frame );
+static BenchResult bench_measure( const BenchScenario& scenario, BenchPath path );
+static const BenchResult* bench_find( const BenchResult* results, int number_of_results, const char* scenario, const char* path );
+static int bench_read_csv( const char* filename, BenchResult* results, int max_results );
+static bool bench_write_csv( const char* filename, const BenchResult* results, int number_of_results );
+static bool bench_write_json( const char* filename, const BenchResult* results, int number_of_results );
+static uint32_t bench_random( uint32_t* state );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const BenchScenario bench_scenarios[] =
+{
+    { "static", false, false, false, false, 0 },
+    { "moving", true, false, false, false, 0 },
+    { "rotated", true, true, false, false, 0 },
+    { "many_textures", true, false, true, false, 0 },
+    { "palettes", true, false, false, true, 0 },
+    { "interleaved_rects", true, false, false, false, 32 }
+};
+
+static const char* bench_path_names[ NUMBER_OF_BENCH_PATHS ] = { "per_call", "batched", "pieces" };
+
+// Texture 0 is an atlas sprite; the others are images loaded on their own, so each is a separate GL texture.
+static Texture bench_textures[ BENCH_TEXTURES ] = { -1, -1, -1 };
+static const Rect bench_sources[ BENCH_TEXTURES ] =
+{
+    { 16.0f, 16.0f, BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE },
+    { 0.0f, 0.0f, BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE },
+    { 0.0f, 0.0f, BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE }
+};
+
+static float sprite_x[ BENCH_SPRITES ];
+static float sprite_y[ BENCH_SPRITES ];
+static SpritePiece bench_pieces[ BENCH_SPRITES ];
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+int bench_run( const char* baseline_filename )
+{
+    palette_load( "palettes" );
+    bench_textures[ 1 ] = render_get_texture( "autumn" );
+    bench_textures[ 2 ] = render_get_texture( "font" );
+    render_load_atlas( "sprites" );
+    bench_textures[ 0 ] = render_get_texture( "hydrant" );
+    for ( Texture texture : bench_textures )
+    {
+        if ( texture < 0 )
+        {
+            printf( "Bench: couldn’t load the scenarios’ textures.\n" );
+            return -1;
+        }
+    }
+
+    uint32_t seed = 12345;
+    for ( int sprite = 0; sprite < BENCH_SPRITES; ++sprite )
+    {
+        sprite_x[ sprite ] = ( float )( bench_random( &seed ) % ( CONFIG_WINDOW_WIDTH_PIXELS - 16 ) );
+        sprite_y[ sprite ] = ( float )( bench_random( &seed ) % ( CONFIG_WINDOW_HEIGHT_PIXELS - 16 ) );
+    }
+
+    // Shaders finish compiling on the first frame, & report it; get that out o’ the way o’ the table.
+    render_start();
+    render_present();
+
+    static BenchResult baseline[ MAX_BENCH_RESULTS ];
+    const int number_of_baseline_results = ( baseline_filename ) ? bench_read_csv( baseline_filename, baseline, MAX_BENCH_RESULTS ) : 0;
+
+    static BenchResult results[ MAX_BENCH_RESULTS ];
+    int number_of_results = 0;
+    printf( "%-18s %-10s %12s %10s %10s %10s\n", "scenario", "path", "sprites/ms", "ms/frame", "draws", "vs base" );
+    for ( const BenchScenario& scenario : bench_scenarios )
+    {
+        for ( int path = 0; path < NUMBER_OF_BENCH_PATHS; ++path )
+        {
+            if ( !bench_path_fits( scenario, ( BenchPath )( path ) ) || number_of_results == MAX_BENCH_RESULTS )
+            {
+                continue;
+            }
+
+            const BenchResult& result = results[ number_of_results++ ] = bench_measure( scenario, ( BenchPath )( path ) );
+            char change[ 32 ] = "";
+            const BenchResult* base = bench_find( baseline, number_of_baseline_results, result.scenario, result.path );
+            if ( base && base->sprites_per_ms > 0.0 )
+            {
+                snprintf( change, sizeof( change ), "%+.1f%%", ( result.sprites_per_ms / base->sprites_per_ms - 1.0 ) * 100.0 );
+            }
+            printf( "%-18s %-10s %12.1f %10.3f %10.1f %10s\n", result.scenario, result.path, result.sprites_per_ms, result.ms_per_frame, result.draw_calls_per_frame, change );
+        }
+    }
+    render_set_batch_limit( BENCH_SPRITES );
+
+    const bool written = bench_write_csv( BENCH_OUTPUT_DIRECTORY "results.csv", results, number_of_results )
+        && bench_write_json( BENCH_OUTPUT_DIRECTORY "results.json", results, number_of_results );
+    if ( written )
+    {
+        printf( "Bench: results written to " BENCH_OUTPUT_DIRECTORY "results.csv & .json.\n" );
+    }
+    return ( written ) ? 0 : -1;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static bool bench_path_fits( const BenchScenario& scenario, BenchPath path )
+{
+    if ( path != BENCH_PATH_PIECES )
+    {
+        return true;
+    }
+    return !scenario.rotated && !scenario.many_textures && !scenario.palettes && scenario.rect_every == 0;
+}
+
+static void bench_draw( const BenchScenario& scenario, BenchPath path, int frame )
+{
+    const float drift = ( scenario.moving ) ? ( float )( frame % 16 ) : 0.0f;
+    if ( path == BENCH_PATH_PIECES )
+    {
+        for ( int sprite = 0; sprite < BENCH_SPRITES; ++sprite )
+        {
+            bench_pieces[ sprite ] = { bench_sources[ 0 ], sprite_x[ sprite ] + drift, sprite_y[ sprite ] };
+        }
+        render_texture_pieces( bench_textures[ 0 ], bench_pieces, BENCH_SPRITES, 0.0f, 0.0f, 0 );
+        return;
+    }
+
+    for ( int sprite = 0; sprite < BENCH_SPRITES; ++sprite )
+    {
+        if ( scenario.rect_every > 0 && sprite % scenario.rect_every == 0 )
+        {
+            render_rect( { sprite_x[ sprite ], sprite_y[ sprite ], 8.0f, 8.0f }, 1 + sprite % 7 );
+        }
+        const int texture = ( scenario.many_textures ) ? sprite % BENCH_TEXTURES : 0;
+        const int palette = ( scenario.palettes ) ? sprite % 4 : 0;
+        const float rotation = ( scenario.rotated ) ? ( float )( ( sprite * 13 + frame * 2 ) % 360 ) : 0.0f;
+        const Rect dest = { sprite_x[ sprite ] + drift, sprite_y[ sprite ], BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE };
+        render_texture( bench_textures[ texture ], bench_sources[ texture ], dest, palette, false, false, rotation, 1.0f, BENCH_SPRITE_SIZE / 2.0f, BENCH_SPRITE_SIZE / 2.0f );
+    }
+}
+
+// Runs a few untimed frames, then at least BENCH_MIN_FRAMES & BENCH_MIN_MS worth o’ timed ones.
+static BenchResult bench_measure( const BenchScenario& scenario, BenchPath path )
+{
+    render_set_batch_limit( ( path == BENCH_PATH_PER_CALL ) ? 1 : BENCH_SPRITES );
+    for ( int frame = 0; frame < BENCH_WARMUP_FRAMES; ++frame )
+    {
+        render_start();
+        bench_draw( scenario, path, frame );
+        render_present();
+    }
+
+    int frames = 0;
+    double total_ms = 0.0;
+    long long draw_calls = 0;
+    while ( frames < BENCH_MIN_FRAMES || total_ms < BENCH_MIN_MS )
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        render_start();
+        bench_draw( scenario, path, frames );
+        render_present();
+        total_ms += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        draw_calls += render_get_stats().draw_calls;
+        ++frames;
+    }
+
+    BenchResult result = {};
+    snprintf( result.scenario, sizeof( result.scenario ), "%s", scenario.name );
+    snprintf( result.path, sizeof( result.path ), "%s", bench_path_names[ path ] );
+    result.sprites = BENCH_SPRITES;
+    result.frames = frames;
+    result.ms_per_frame = total_ms / frames;
+    result.sprites_per_ms = ( double )( BENCH_SPRITES ) * frames / total_ms;
+    result.draw_calls_per_frame = ( double )( draw_calls ) / frames;
+    return result;
+}
+
+static const BenchResult* bench_find( const BenchResult* results, int number_of_results, const char* scenario, const char* path )
+{
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        if ( strcmp( results[ result ].scenario, scenario ) == 0 && strcmp( results[ result ].path, path ) == 0 )
+        {
+            return &results[ result ];
+        }
+    }
+    return nullptr;
+}
+
+static int bench_read_csv( const char* filename, BenchResult* results, int max_results )
+{
+    FILE* file = fopen( filename, "r" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t open baseline %s\n", filename );
+        return 0;
+    }
+
+    int number_of_results = 0;
+    char line[ 256 ];
+    while ( number_of_results < max_results && fgets( line, sizeof( line ), file ) )
+    {
+        BenchResult& result = results[ number_of_results ];
+        // The header & anything else that isn’t a result fails to scan & is skipped.
+        if ( sscanf( line, "%63[^,],%63[^,],%d,%d,%lf,%lf,%lf", result.scenario, result.path, &result.sprites, &result.frames, &result.ms_per_frame, &result.sprites_per_ms, &result.draw_calls_per_frame ) == 7 )
+        {
+            ++number_of_results;
+        }
+    }
+    fclose( file );
+    return number_of_results;
+}
+
+static bool bench_write_csv( const char* filename, const BenchResult* results, int number_of_results )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t write %s\n", filename );
+        return false;
+    }
+    fprintf( file, "scenario,path,sprites,frames,ms_per_frame,sprites_per_ms,draw_calls_per_frame\n" );
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        const BenchResult& r = results[ result ];
+        fprintf( file, "%s,%s,%d,%d,%f,%f,%f\n", r.scenario, r.path, r.sprites, r.frames, r.ms_per_frame, r.sprites_per_ms, r.draw_calls_per_frame );
+    }
+    fclose( file );
+    return true;
+}
+
+static bool bench_write_json( const char* filename, const BenchResult* results, int number_of_results )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t write %s\n", filename );
+        return false;
+    }
+    fprintf( file, "{\n  \"backend\": \"%s\",\n  \"results\": [\n", BENCH_BACKEND );
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        const BenchResult& r = results[ result ];
+        fprintf
+        (
+            file,
+            "    { \"scenario\": \"%s\", \"path\": \"%s\", \"sprites\": %d, \"frames\": %d, \"ms_per_frame\": %f, \"sprites_per_ms\": %f, \"draw_calls_per_frame\": %f }%s\n",
+            r.scenario, r.path, r.sprites, r.frames, r.ms_per_frame, r.sprites_per_ms, r.draw_calls_per_frame,
+            ( result + 1 < number_of_results ) ? "," : ""
+        );
+    }
+    fprintf( file, "  ]\n}\n" );
+    fclose( file );
+    return true;
+}
+
+// xorshift32, so every run & platform draws the same field.
+static uint32_t bench_random( uint32_t* state )
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+#endif
@@ -0,0 +1,170 @@
+#include "config.hpp"
+#include "frame_histogram.hpp"
+
+#if CONFIG_FRAME_HISTOGRAM
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Values below 2^SUB_BUCKET_BITS µs get a bucket each; above, every doubling is split into half that many
+// buckets, so a bucket’s never wider than 1/64 o’ the values in it.
+#define SUB_BUCKET_BITS 7
+#define SUB_BUCKET_COUNT ( 1 << SUB_BUCKET_BITS )
+#define SUB_BUCKET_HALF ( SUB_BUCKET_COUNT / 2 )
+#define MAX_VALUE_BITS 32
+#define HISTOGRAM_BUCKETS ( ( MAX_VALUE_BITS - SUB_BUCKET_BITS + 2 ) * SUB_BUCKET_HALF )
+#define MAX_HISTOGRAM_VALUE ( ( 1ull << MAX_VALUE_BITS ) - 1 )
+#define HITCH_60_FPS_MS ( 1000.0 / 60.0 )
+#define HITCH_30_FPS_MS ( 1000.0 / 30.0 )
+
+struct FrameHistogram
+{
+    uint64_t counts[ HISTOGRAM_BUCKETS ];
+    uint64_t frames;
+    uint64_t max_us;
+    uint64_t hitches_over_16ms;
+    uint64_t hitches_over_33ms;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static int frame_histogram_get_bucket( uint64_t us );
+static uint64_t frame_histogram_get_bucket_top( int bucket );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const char* frame_clock_names[ FRAME_CLOCK_COUNT ] = { "cpu", "present", "gpu" };
+static FrameHistogram frame_histograms[ FRAME_CLOCK_COUNT ];
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void frame_histogram_record( FrameClock clock, double ms )
+{
+    FrameHistogram& histogram = frame_histograms[ clock ];
+    const uint64_t us = ( uint64_t )( std::llround( std::max( ms, 0.0 ) * 1000.0 ) );
+    const uint64_t clamped_us = std::min( us, ( uint64_t )( MAX_HISTOGRAM_VALUE ) );
+    ++histogram.counts[ frame_histogram_get_bucket( clamped_us ) ];
+    ++histogram.frames;
+    histogram.max_us = std::max( histogram.max_us, clamped_us );
+    histogram.hitches_over_16ms += ( ms > HITCH_60_FPS_MS ) ? 1 : 0;
+    histogram.hitches_over_33ms += ( ms > HITCH_30_FPS_MS ) ? 1 : 0;
+}
+
+double frame_histogram_get_percentile( FrameClock clock, double percentile )
+{
+    const FrameHistogram& histogram = frame_histograms[ clock ];
+    if ( histogram.frames == 0 )
+    {
+        return 0.0;
+    }
+
+    const uint64_t rank = std::max( ( uint64_t )( 1 ), ( uint64_t )( std::ceil( percentile * histogram.frames ) ) );
+    uint64_t seen = 0;
+    for ( int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket )
+    {
+        seen += histogram.counts[ bucket ];
+        if ( seen >= rank )
+        {
+            return std::min( frame_histogram_get_bucket_top( bucket ), histogram.max_us ) / 1000.0;
+        }
+    }
+    return histogram.max_us / 1000.0;
+}
+
+FrameHistogramSummary frame_histogram_get_summary( FrameClock clock )
+{
+    const FrameHistogram& histogram = frame_histograms[ clock ];
+    return
+    {
+        histogram.frames,
+        frame_histogram_get_percentile( clock, 0.5 ),
+        frame_histogram_get_percentile( clock, 0.95 ),
+        frame_histogram_get_percentile( clock, 0.99 ),
+        histogram.max_us / 1000.0,
+        histogram.hitches_over_16ms,
+        histogram.hitches_over_33ms
+    };
+}
+
+const char* frame_histogram_get_clock_name( FrameClock clock )
+{
+    return frame_clock_names[ clock ];
+}
+
+void frame_histogram_reset()
+{
+    for ( FrameHistogram& histogram : frame_histograms )
+    {
+        histogram = {};
+    }
+}
+
+void frame_histogram_print_report()
+{
+    printf( "Frame times in ms:\n" );
+    printf( "  %-8s %8s %8s %8s %8s %8s %9s %9s\n", "clock", "frames", "p50", "p95", "p99", "max", ">16.7 ms", ">33.3 ms" );
+    for ( int clock = 0; clock < FRAME_CLOCK_COUNT; ++clock )
+    {
+        const FrameHistogramSummary summary = frame_histogram_get_summary( ( FrameClock )( clock ) );
+        if ( summary.frames == 0 )
+        {
+            continue;
+        }
+        printf
+        (
+            "  %-8s %8llu %8.2f %8.2f %8.2f %8.2f %9llu %9llu\n",
+            frame_clock_names[ clock ], ( unsigned long long )( summary.frames ), summary.p50_ms, summary.p95_ms, summary.p99_ms, summary.max_ms,
+            ( unsigned long long )( summary.hitches_over_16ms ), ( unsigned long long )( summary.hitches_over_33ms )
+        );
+    }
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static int frame_histogram_get_bucket( uint64_t us )
+{
+    if ( us < SUB_BUCKET_COUNT )
+    {
+        return ( int )( us );
+    }
+    int magnitude = 0;
+    while ( ( us >> magnitude ) >= SUB_BUCKET_COUNT )
+    {
+        ++magnitude;
+    }
+    return ( magnitude + 1 ) * SUB_BUCKET_HALF + ( int )( us >> magnitude ) - SUB_BUCKET_HALF;
+}
+
+static uint64_t frame_histogram_get_bucket_top( int bucket )
+{
+    if ( bucket < SUB_BUCKET_COUNT )
+    {
+        return ( uint64_t )( bucket );
+    }
+    const int magnitude = bucket / SUB_BUCKET_HALF - 1;
+    const uint64_t bottom = ( uint64_t )( bucket % SUB_BUCKET_HALF + SUB_BUCKET_HALF ) << magnitude;
+    return bottom + ( ( uint64_t )( 1 ) << magnitude ) - 1;
+}
+
+#endif
@@ -3,7 +3,9 @@
 #include "game.hpp"
 #include "glad.h"
 #include "glfw3.h"
+#include "ogl_error.hpp"
 #include "render.hpp"
+#include "soft_render.hpp"
 
 bool game_init()
 {
@@ -15,6 +17,10 @@ bool game_init()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if ( CONFIG_OGL_ERROR_LEVEL == OGL_ERRORS_SYNCHRONOUS )
+    {
+        glfwWindowHint( GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE );
+    }
 
     if ( !render_init_window() )
     {
@@ -43,5 +49,8 @@ bool game_init()
 
 void game_close()
 {
+#if CONFIG_SOFTWARE_RENDERER
+    soft_render_close();
+#endif
     glfwTerminate();
 }
\ No newline at end of file
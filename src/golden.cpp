@@ -0,0 +1,532 @@
+#include "config.hpp"
+#include "golden.hpp"
+
+#if CONFIG_GOLDEN
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "palette.hpp"
+#include "rect.hpp"
+#include "render.hpp"
+#include "soft_render.hpp"
+#include "text.hpp"
+
+#define GOLDEN_WIDTH CONFIG_WINDOW_WIDTH_PIXELS
+#define GOLDEN_HEIGHT CONFIG_WINDOW_HEIGHT_PIXELS
+#define GOLDEN_FRAME_SIZE ( GOLDEN_WIDTH * GOLDEN_HEIGHT )
+#define MAX_GOLDEN_CAPTURES 8
+#define MAX_FILENAME 255
+#define GOLDEN_REFERENCE_DIRECTORY "tests/golden/"
+#define GOLDEN_OUTPUT_DIRECTORY "obj/golden/"
+#define GOLDEN_TIMES_FILE GOLDEN_OUTPUT_DIRECTORY "times.csv"
+#define CROWD_SPRITES 2000
+
+// A scene draws one frame between render_start & render_present; begin & end, if set, run once ’round all its
+// frames, for state like scanline tables that would otherwise leak into the next scene. Frames 0, frames_per_capture,
+// 2 × frames_per_capture & so on are checked. same_as, if set, names the scene just before, which draws the same
+// thing another way; its captures must match this scene’s pixel for pixel, whatever the references say.
+struct GoldenScene
+{
+    const char* name;
+    int frames;
+    int frames_per_capture;
+    void ( *begin )();
+    void ( *draw )( int frame );
+    void ( *end )();
+    const char* same_as;
+};
+
+struct GoldenTime
+{
+    char name[ MAX_FILENAME + 1 ];
+    double mean_ms;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void golden_draw_sprite_grid( Texture autumn, Texture hydrant, int frame );
+static void golden_draw_images( int frame );
+static void golden_draw_atlas( int frame );
+static void golden_draw_text( int frame );
+static void golden_draw_rects( int frame );
+static void golden_draw_crowd( int frame );
+static void golden_begin_scanlines();
+static void golden_draw_scanlines( int frame );
+static void golden_end_scanlines();
+static bool golden_run_scene( const GoldenScene& scene, bool update, double* mean_ms, double* best_ms );
+static bool golden_check( const GoldenScene& scene, const unsigned char* frames, int number_of_captures );
+static bool golden_check_same( const GoldenScene& scene, int number_of_captures );
+static bool golden_write_pgm( const char* filename, const unsigned char* indices, int width, int height );
+static unsigned char* golden_read_pgm( const char* filename, int* width, int* height );
+static int golden_read_times( GoldenTime* times, int max_times );
+static uint32_t golden_random( uint32_t* state );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const GoldenScene golden_scenes[] =
+{
+    { "images", 31, 15, nullptr, golden_draw_images, nullptr, nullptr },
+    { "atlas", 31, 15, nullptr, golden_draw_atlas, nullptr, "images" },
+    { "text", 31, 30, nullptr, golden_draw_text, nullptr, nullptr },
+    { "rects", 31, 30, nullptr, golden_draw_rects, nullptr, nullptr },
+    { "crowd", 61, 60, nullptr, golden_draw_crowd, nullptr, nullptr },
+    { "scanlines", 31, 30, golden_begin_scanlines, golden_draw_scanlines, golden_end_scanlines, nullptr }
+};
+#define NUMBER_OF_GOLDEN_SCENES ( ( int )( sizeof( golden_scenes ) / sizeof( golden_scenes[ 0 ] ) ) )
+
+// Textures loaded from their own .jwi files ’fore the atlas, whose sprites o’ the same names replace them in the
+// name lookup; the images & atlas scenes draw the same thing through each, & must come out the same.
+static Texture image_autumn = -1;
+static Texture image_hydrant = -1;
+static Texture atlas_autumn = -1;
+static Texture atlas_hydrant = -1;
+static Font golden_font = -1;
+static int holes_palette_row = -1;
+static unsigned char captured_frames[ MAX_GOLDEN_CAPTURES * GOLDEN_FRAME_SIZE ];
+static unsigned char previous_frames[ MAX_GOLDEN_CAPTURES * GOLDEN_FRAME_SIZE ];
+static const char* previous_scene = nullptr;
+static int previous_captures = 0;
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+int golden_run( bool update )
+{
+    palette_load( "palettes" );
+    image_autumn = render_get_texture( "autumn" );
+    image_hydrant = render_get_texture( "hydrant" );
+    render_load_atlas( "sprites" );
+    atlas_autumn = render_get_texture( "autumn" );
+    atlas_hydrant = render_get_texture( "hydrant" );
+    golden_font = text_load_font( "font" );
+
+    // Row 0 with every even colour see-through, for the scanline scene.
+    unsigned char holes[ PALETTE_ROW_SIZE ];
+    memcpy( holes, palette_get_color( 0, 0 ), PALETTE_ROW_SIZE );
+    for ( int index = 2; index < PALETTE_COLORS; index += 2 )
+    {
+        holes[ index * CHANNELS_PER_COLOR + 3 ] = 0;
+    }
+    holes_palette_row = palette_add_row( "golden_holes", holes );
+
+    if ( image_autumn < 0 || image_hydrant < 0 || atlas_autumn < 0 || atlas_hydrant < 0 || golden_font < 0 || holes_palette_row < 0 )
+    {
+        printf( "Golden: couldn’t load the scenes’ assets.\n" );
+        return -1;
+    }
+
+    // Shaders finish compiling & the software renderer’s workers start on the first frame; keep that out o’ the times.
+    render_start();
+    render_present();
+
+    GoldenTime last_times[ NUMBER_OF_GOLDEN_SCENES ];
+    const int number_of_last_times = golden_read_times( last_times, NUMBER_OF_GOLDEN_SCENES );
+    FILE* times_file = fopen( GOLDEN_TIMES_FILE, "w" );
+    if ( times_file )
+    {
+        fprintf( times_file, "scene,mean_ms\n" );
+    }
+
+    int failures = 0;
+    printf( "%-12s %6s %10s %10s %10s\n", "scene", "result", "mean ms", "best ms", "vs last" );
+    for ( const GoldenScene& scene : golden_scenes )
+    {
+        double mean_ms;
+        double best_ms;
+        const bool passed = golden_run_scene( scene, update, &mean_ms, &best_ms );
+        if ( !passed )
+        {
+            ++failures;
+        }
+
+        char change[ 32 ] = "";
+        for ( int time = 0; time < number_of_last_times; ++time )
+        {
+            if ( strcmp( last_times[ time ].name, scene.name ) == 0 && last_times[ time ].mean_ms > 0.0 )
+            {
+                snprintf( change, sizeof( change ), "%+.1f%%", ( mean_ms / last_times[ time ].mean_ms - 1.0 ) * 100.0 );
+            }
+        }
+        printf( "%-12s %6s %10.3f %10.3f %10s\n", scene.name, ( update ) ? "saved" : ( passed ) ? "ok" : "FAIL", mean_ms, best_ms, change );
+        if ( times_file )
+        {
+            fprintf( times_file, "%s,%f\n", scene.name, mean_ms );
+        }
+    }
+
+    if ( times_file )
+    {
+        fclose( times_file );
+    }
+    if ( !update )
+    {
+        printf( "Golden: %d o’ %d scenes passed.\n", NUMBER_OF_GOLDEN_SCENES - failures, NUMBER_OF_GOLDEN_SCENES );
+    }
+    return failures;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+// Flips, rotations, scaling, alpha & palette banks, with everything that turns turning by frame.
+static void golden_draw_sprite_grid( Texture autumn, Texture hydrant, int frame )
+{
+    const Rect autumn_src = { 0.0f, 0.0f, 16.0f, 25.0f };
+    const Rect hydrant_src = { 16.0f, 16.0f, 32.0f, 32.0f };
+    for ( int variant = 0; variant < 4; ++variant )
+    {
+        const bool flip_x = ( variant & 1 ) != 0;
+        const bool flip_y = ( variant & 2 ) != 0;
+        const float x = 8.0f + variant * 40.0f;
+        render_texture( autumn, autumn_src, { x, 8.0f, 16.0f, 25.0f }, variant, flip_x, flip_y );
+        render_texture( hydrant, hydrant_src, { x, 40.0f, 32.0f, 32.0f }, variant, flip_x, flip_y );
+    }
+
+    const float rotation = frame * 7.0f;
+    render_texture( autumn, autumn_src, { 200.0f, 16.0f, 32.0f, 50.0f }, 0, false, false, rotation, 1.0f, 16.0f, 25.0f );
+    render_texture( hydrant, hydrant_src, { 260.0f, 16.0f, 32.0f, 32.0f }, 1, false, false, -rotation, 1.0f, 16.0f, 16.0f );
+    render_texture( hydrant, hydrant_src, { 320.0f, 24.0f, 48.0f, 24.0f }, 2, true, false, rotation * 0.5f, 1.0f, 24.0f, 12.0f );
+
+    // Alpha only decides which pixels pass the cutoff, so steps either side o’ it.
+    const float alphas[] = { 0.25f, 0.75f, 1.0f };
+    for ( int step = 0; step < 3; ++step )
+    {
+        render_texture( autumn, autumn_src, { 8.0f + step * 24.0f, 96.0f, 16.0f, 25.0f }, 0, false, false, 0.0f, alphas[ step ] );
+    }
+
+    // Overlaps & sprites hanging off every edge o’ the canvas.
+    for ( int sprite = 0; sprite < 6; ++sprite )
+    {
+        render_texture( hydrant, hydrant_src, { 120.0f + sprite * 10.0f + frame, 100.0f + sprite * 6.0f, 32.0f, 32.0f }, sprite );
+    }
+    render_texture( autumn, autumn_src, { -8.0f + frame * 0.5f, 180.0f, 16.0f, 25.0f }, 0 );
+    render_texture( autumn, autumn_src, { GOLDEN_WIDTH - 8.0f, 200.0f - frame * 0.25f, 16.0f, 25.0f }, 1 );
+    render_texture( hydrant, hydrant_src, { 300.0f, -16.0f + frame * 0.75f, 32.0f, 32.0f }, 2 );
+    render_texture( hydrant, hydrant_src, { 340.0f, GOLDEN_HEIGHT - 16.0f, 32.0f, 32.0f }, 3, false, false, rotation, 1.0f, 16.0f, 16.0f );
+}
+
+static void golden_draw_images( int frame )
+{
+    golden_draw_sprite_grid( image_autumn, image_hydrant, frame );
+}
+
+static void golden_draw_atlas( int frame )
+{
+    golden_draw_sprite_grid( atlas_autumn, atlas_hydrant, frame );
+}
+
+static void golden_draw_text( int frame )
+{
+    text_draw( golden_font, "THE QUICK BROWN FOX\nJUMPS OVER THE LAZY DOG", 8.0f, 8.0f, palette_make_id( 0, 1 ) );
+    text_draw( golden_font, "0123456789 !?.,:;()[]", 8.0f + frame, 64.0f, palette_make_id( 0, 2 ) );
+    text_draw( golden_font, "the quick brown fox", 8.0f, 96.0f + frame * 0.5f, palette_make_id( 1, 1 ) );
+
+    char counter[ 32 ];
+    snprintf( counter, sizeof( counter ), "Frame %d", frame );
+    text_draw( golden_font, counter, GOLDEN_WIDTH - 80.0f, GOLDEN_HEIGHT - 16.0f, palette_make_id( 0, 3 ) );
+}
+
+static void golden_draw_rects( int frame )
+{
+    for ( int rect = 0; rect < 16; ++rect )
+    {
+        render_rect( { rect * 23.0f + frame, rect * 11.0f, 40.0f, 30.0f }, rect + 1 );
+    }
+    render_rect( { -20.0f, -20.0f, 60.0f, 60.0f }, 5 );
+    render_rect( { GOLDEN_WIDTH - 30.0f, GOLDEN_HEIGHT - 30.0f, 60.0f, 60.0f }, 6 );
+    render_rect( { 200.5f, 100.25f, 10.5f, 10.75f }, 7 );
+}
+
+// Lots o’ small sprites in random order ’cross both textures, to time batching.
+static void golden_draw_crowd( int frame )
+{
+    uint32_t seed = 12345;
+    for ( int sprite = 0; sprite < CROWD_SPRITES; ++sprite )
+    {
+        const float x = ( float )( golden_random( &seed ) % ( GOLDEN_WIDTH + 32 ) ) - 16.0f;
+        const float y = ( float )( golden_random( &seed ) % ( GOLDEN_HEIGHT + 32 ) ) - 16.0f;
+        const int palette = ( int )( golden_random( &seed ) % 4 );
+        const float drift = ( float )( frame * ( sprite % 3 ) );
+        if ( golden_random( &seed ) & 1 )
+        {
+            render_texture( atlas_hydrant, { 16.0f, 16.0f, 16.0f, 16.0f }, { x + drift, y, 16.0f, 16.0f }, palette );
+        }
+        else
+        {
+            render_texture( atlas_autumn, { 0.0f, 0.0f, 16.0f, 25.0f }, { x, y - drift, 16.0f, 25.0f }, palette );
+        }
+    }
+}
+
+static void golden_begin_scanlines()
+{
+    render_set_scanline_palette( 48, 64, holes_palette_row );
+    render_set_scanline_palette( 160, 8, holes_palette_row );
+}
+
+static void golden_draw_scanlines( int frame )
+{
+    golden_draw_sprite_grid( atlas_autumn, atlas_hydrant, frame );
+    render_rect( { 240.0f, 120.0f, 100.0f, 60.0f }, 2 );
+    render_rect( { 250.0f, 130.0f, 80.0f, 40.0f }, 3 );
+}
+
+static void golden_end_scanlines()
+{
+    render_reset_scanlines();
+}
+
+static bool golden_run_scene( const GoldenScene& scene, bool update, double* mean_ms, double* best_ms )
+{
+    if ( scene.begin )
+    {
+        scene.begin();
+    }
+
+    int number_of_captures = 0;
+    double total_ms = 0.0;
+    *best_ms = 0.0;
+    for ( int frame = 0; frame < scene.frames; ++frame )
+    {
+        palette_update();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        render_start();
+        scene.draw( frame );
+        render_present();
+        const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        total_ms += ms;
+        *best_ms = ( frame == 0 ) ? ms : std::min( *best_ms, ms );
+
+        if ( frame % scene.frames_per_capture == 0 && number_of_captures < MAX_GOLDEN_CAPTURES )
+        {
+            memcpy( &captured_frames[ number_of_captures * GOLDEN_FRAME_SIZE ], soft_render_get_indices(), GOLDEN_FRAME_SIZE );
+            ++number_of_captures;
+        }
+    }
+    *mean_ms = total_ms / scene.frames;
+
+    if ( scene.end )
+    {
+        scene.end();
+    }
+
+    const bool same = !scene.same_as || golden_check_same( scene, number_of_captures );
+    memcpy( previous_frames, captured_frames, ( size_t )( number_of_captures ) * GOLDEN_FRAME_SIZE );
+    previous_scene = scene.name;
+    previous_captures = number_of_captures;
+
+    if ( update )
+    {
+        char filename[ MAX_FILENAME + 1 ];
+        snprintf( filename, sizeof( filename ), GOLDEN_REFERENCE_DIRECTORY "%s.pgm", scene.name );
+        return golden_write_pgm( filename, captured_frames, GOLDEN_WIDTH, GOLDEN_HEIGHT * number_of_captures ) && same;
+    }
+    const bool passed = golden_check( scene, captured_frames, number_of_captures );
+    return passed && same;
+}
+
+// On a mismatch the frames drawn are written to obj/golden/ to diff against the reference.
+static bool golden_check( const GoldenScene& scene, const unsigned char* frames, int number_of_captures )
+{
+    char filename[ MAX_FILENAME + 1 ];
+    snprintf( filename, sizeof( filename ), GOLDEN_REFERENCE_DIRECTORY "%s.pgm", scene.name );
+    int width;
+    int height;
+    unsigned char* reference = golden_read_pgm( filename, &width, &height );
+    if ( !reference )
+    {
+        return false;
+    }
+
+    bool passed = true;
+    if ( width != GOLDEN_WIDTH || height != GOLDEN_HEIGHT * number_of_captures )
+    {
+        printf( "Golden: %s is %d x %d, but the scene draws %d x %d.\n", filename, width, height, GOLDEN_WIDTH, GOLDEN_HEIGHT * number_of_captures );
+        passed = false;
+    }
+    else
+    {
+        for ( int capture = 0; capture < number_of_captures; ++capture )
+        {
+            const unsigned char* expected = &reference[ capture * GOLDEN_FRAME_SIZE ];
+            const unsigned char* drawn = &frames[ capture * GOLDEN_FRAME_SIZE ];
+            int mismatches = 0;
+            int first = -1;
+            for ( int pixel = 0; pixel < GOLDEN_FRAME_SIZE; ++pixel )
+            {
+                if ( expected[ pixel ] != drawn[ pixel ] )
+                {
+                    first = ( first < 0 ) ? pixel : first;
+                    ++mismatches;
+                }
+            }
+            if ( mismatches > 0 )
+            {
+                printf
+                (
+                    "Golden: %s frame %d has %d pixels wrong, first at %d, %d: index %d ’stead o’ %d.\n",
+                    scene.name, capture * scene.frames_per_capture, mismatches, first % GOLDEN_WIDTH, first / GOLDEN_WIDTH,
+                    drawn[ first ], expected[ first ]
+                );
+                passed = false;
+            }
+        }
+    }
+    free( reference );
+
+    if ( !passed )
+    {
+        snprintf( filename, sizeof( filename ), GOLDEN_OUTPUT_DIRECTORY "%s.pgm", scene.name );
+        golden_write_pgm( filename, frames, GOLDEN_WIDTH, GOLDEN_HEIGHT * number_of_captures );
+    }
+    return passed;
+}
+
+// Checked in update runs too, so a difference ’tween the two ways o’ drawing can’t be saved as a reference.
+static bool golden_check_same( const GoldenScene& scene, int number_of_captures )
+{
+    if ( !previous_scene || strcmp( previous_scene, scene.same_as ) != 0 || previous_captures != number_of_captures )
+    {
+        printf( "Golden: %s must come right after %s, with as many captures.\n", scene.name, scene.same_as );
+        return false;
+    }
+
+    bool same = true;
+    for ( int capture = 0; capture < number_of_captures; ++capture )
+    {
+        const unsigned char* expected = &previous_frames[ capture * GOLDEN_FRAME_SIZE ];
+        const unsigned char* drawn = &captured_frames[ capture * GOLDEN_FRAME_SIZE ];
+        int mismatches = 0;
+        int first = -1;
+        for ( int pixel = 0; pixel < GOLDEN_FRAME_SIZE; ++pixel )
+        {
+            if ( expected[ pixel ] != drawn[ pixel ] )
+            {
+                first = ( first < 0 ) ? pixel : first;
+                ++mismatches;
+            }
+        }
+        if ( mismatches > 0 )
+        {
+            printf
+            (
+                "Golden: %s frame %d differs from %s in %d pixels, first at %d, %d: index %d ’stead o’ %d.\n",
+                scene.name, capture * scene.frames_per_capture, scene.same_as, mismatches, first % GOLDEN_WIDTH, first / GOLDEN_WIDTH,
+                drawn[ first ], expected[ first ]
+            );
+            same = false;
+        }
+    }
+    return same;
+}
+
+// Binary PGMs hold the indices as they are, so any image viewer can show them, if dimly.
+static bool golden_write_pgm( const char* filename, const unsigned char* indices, int width, int height )
+{
+    FILE* file = fopen( filename, "wb" );
+    if ( !file )
+    {
+        printf( "Golden: couldn’t write %s\n", filename );
+        return false;
+    }
+    fprintf( file, "P5\n%d %d\n255\n", width, height );
+    const bool written = fwrite( indices, 1, ( size_t )( width * height ), file ) == ( size_t )( width * height );
+    fclose( file );
+    if ( !written )
+    {
+        printf( "Golden: couldn’t write all o’ %s\n", filename );
+    }
+    return written;
+}
+
+static unsigned char* golden_read_pgm( const char* filename, int* width, int* height )
+{
+    FILE* file = fopen( filename, "rb" );
+    if ( !file )
+    {
+        printf( "Golden: no reference %s; `make golden UPDATE=1` makes one.\n", filename );
+        return nullptr;
+    }
+
+    int max_value;
+    if ( fscanf( file, "P5 %d %d %d", width, height, &max_value ) != 3 || max_value != 255 || fgetc( file ) == EOF || *width <= 0 || *height <= 0 )
+    {
+        printf( "Golden: %s isn’t an 8-bit binary PGM.\n", filename );
+        fclose( file );
+        return nullptr;
+    }
+
+    const size_t size = ( size_t )( *width ) * ( size_t )( *height );
+    unsigned char* indices = ( unsigned char* )( malloc( size ) );
+    if ( !indices || fread( indices, 1, size, file ) != size )
+    {
+        printf( "Golden: couldn’t read all o’ %s\n", filename );
+        free( indices );
+        fclose( file );
+        return nullptr;
+    }
+    fclose( file );
+    return indices;
+}
+
+static int golden_read_times( GoldenTime* times, int max_times )
+{
+    FILE* file = fopen( GOLDEN_TIMES_FILE, "r" );
+    if ( !file )
+    {
+        return 0;
+    }
+
+    int number_of_times = 0;
+    char line[ MAX_FILENAME + 64 ];
+    if ( !fgets( line, sizeof( line ), file ) ) // Header.
+    {
+        fclose( file );
+        return 0;
+    }
+    while ( number_of_times < max_times && fgets( line, sizeof( line ), file ) )
+    {
+        char* comma = strchr( line, ',' );
+        if ( !comma || comma - line > MAX_FILENAME )
+        {
+            continue;
+        }
+        *comma = '\0';
+        strcpy( times[ number_of_times ].name, line );
+        times[ number_of_times ].mean_ms = atof( comma + 1 );
+        ++number_of_times;
+    }
+    fclose( file );
+    return number_of_times;
+}
+
+// xorshift32, so scenes come out the same on every platform.
+static uint32_t golden_random( uint32_t* state )
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+#endif
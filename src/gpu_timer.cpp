@@ -0,0 +1,233 @@
+#include "config.hpp"
+#include "gpu_timer.hpp"
+
+#if CONFIG_GPU_TIMERS
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include "frame_histogram.hpp"
+#include "glad.h"
+
+// Results are read this many frames after they’re recorded, by which point the GPU’s almost always done with them.
+#define GPU_TIMER_FRAMES_IN_FLIGHT 3
+// Room for a frame that swaps ’tween rects & sprite batches every few dozen sprites; frames needing mo’ are
+// left out o’ the stats ’stead o’ undercounted.
+#define MAX_GPU_TIMER_INTERVALS 1024
+
+struct GpuTimerInterval
+{
+    GpuPass pass;
+    int begin_query;
+    int end_query;
+};
+
+struct GpuTimerFrame
+{
+    unsigned int queries[ MAX_GPU_TIMER_INTERVALS * 2 ];
+    GpuTimerInterval intervals[ MAX_GPU_TIMER_INTERVALS ];
+    int number_of_intervals;
+    int number_of_queries;
+    int open_interval[ GPU_PASS_COUNT ];
+    bool overflowed;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void gpu_timer_read_frame( GpuTimerFrame& frame );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const char* gpu_pass_names[ GPU_PASS_COUNT ] = { "frame", "rects", "sprites", "resolve" };
+
+static GpuTimerFrame gpu_timer_frames[ GPU_TIMER_FRAMES_IN_FLIGHT ];
+static int gpu_timer_frame = -1;
+
+// Per pass, nanoseconds for each o’ the last CONFIG_GPU_TIMER_WINDOW frames read back.
+static uint64_t gpu_pass_history[ GPU_PASS_COUNT ][ CONFIG_GPU_TIMER_WINDOW ];
+static int gpu_history_position = 0;
+static int gpu_history_frames = 0;
+static int gpu_frames_not_ready = 0;
+static int gpu_frames_overflowed = 0;
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void gpu_timer_init()
+{
+    for ( GpuTimerFrame& frame : gpu_timer_frames )
+    {
+        glGenQueries( MAX_GPU_TIMER_INTERVALS * 2, frame.queries );
+        frame.number_of_intervals = 0;
+        frame.number_of_queries = 0;
+        frame.overflowed = false;
+    }
+}
+
+void gpu_timer_begin_frame()
+{
+    gpu_timer_frame = ( gpu_timer_frame + 1 ) % GPU_TIMER_FRAMES_IN_FLIGHT;
+    GpuTimerFrame& frame = gpu_timer_frames[ gpu_timer_frame ];
+    gpu_timer_read_frame( frame );
+    frame.number_of_intervals = 0;
+    frame.number_of_queries = 0;
+    frame.overflowed = false;
+    std::fill( frame.open_interval, frame.open_interval + GPU_PASS_COUNT, -1 );
+}
+
+void gpu_timer_begin( GpuPass pass )
+{
+    if ( gpu_timer_frame < 0 )
+    {
+        return;
+    }
+    GpuTimerFrame& frame = gpu_timer_frames[ gpu_timer_frame ];
+    if ( frame.open_interval[ pass ] >= 0 )
+    {
+        return;
+    }
+    if ( pass != GPU_PASS_FRAME )
+    {
+        for ( int other = GPU_PASS_FRAME + 1; other < GPU_PASS_COUNT; ++other )
+        {
+            gpu_timer_end( ( GpuPass )( other ) );
+        }
+    }
+    if ( frame.number_of_intervals == MAX_GPU_TIMER_INTERVALS )
+    {
+        frame.overflowed = true;
+        return;
+    }
+    GpuTimerInterval& interval = frame.intervals[ frame.number_of_intervals ];
+    interval = { pass, frame.number_of_queries, -1 };
+    glQueryCounter( frame.queries[ frame.number_of_queries++ ], GL_TIMESTAMP );
+    frame.open_interval[ pass ] = frame.number_of_intervals++;
+}
+
+void gpu_timer_end( GpuPass pass )
+{
+    if ( gpu_timer_frame < 0 )
+    {
+        return;
+    }
+    GpuTimerFrame& frame = gpu_timer_frames[ gpu_timer_frame ];
+    if ( pass == GPU_PASS_FRAME )
+    {
+        for ( int other = GPU_PASS_FRAME + 1; other < GPU_PASS_COUNT; ++other )
+        {
+            gpu_timer_end( ( GpuPass )( other ) );
+        }
+    }
+    if ( frame.open_interval[ pass ] < 0 )
+    {
+        return;
+    }
+    frame.intervals[ frame.open_interval[ pass ] ].end_query = frame.number_of_queries;
+    glQueryCounter( frame.queries[ frame.number_of_queries++ ], GL_TIMESTAMP );
+    frame.open_interval[ pass ] = -1;
+}
+
+GpuPassStats gpu_timer_get_stats( GpuPass pass )
+{
+    GpuPassStats stats = { 0.0, 0.0, 0.0, gpu_history_frames };
+    if ( gpu_history_frames == 0 )
+    {
+        return stats;
+    }
+    uint64_t total = 0;
+    uint64_t max = 0;
+    for ( int i = 0; i < gpu_history_frames; ++i )
+    {
+        total += gpu_pass_history[ pass ][ i ];
+        max = std::max( max, gpu_pass_history[ pass ][ i ] );
+    }
+    const int last = ( gpu_history_position + CONFIG_GPU_TIMER_WINDOW - 1 ) % CONFIG_GPU_TIMER_WINDOW;
+    stats.last_ms = gpu_pass_history[ pass ][ last ] / 1000000.0;
+    stats.average_ms = total / 1000000.0 / gpu_history_frames;
+    stats.max_ms = max / 1000000.0;
+    return stats;
+}
+
+const char* gpu_timer_get_pass_name( GpuPass pass )
+{
+    return gpu_pass_names[ pass ];
+}
+
+void gpu_timer_print_report()
+{
+    printf( "GPU passes over the last %d frames read back (%d frames weren’t ready in time, %d had too many passes to time):\n", gpu_history_frames, gpu_frames_not_ready, gpu_frames_overflowed );
+    for ( int pass = 0; pass < GPU_PASS_COUNT; ++pass )
+    {
+        const GpuPassStats stats = gpu_timer_get_stats( ( GpuPass )( pass ) );
+        printf( "  %-8s %7.3f ms average, %7.3f ms max\n", gpu_pass_names[ pass ], stats.average_ms, stats.max_ms );
+    }
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+// Only reads results the GPU already has; a frame that isn’t done yet is skipped ’stead o’ waited on.
+static void gpu_timer_read_frame( GpuTimerFrame& frame )
+{
+    if ( frame.number_of_queries == 0 )
+    {
+        return;
+    }
+    int available = GL_FALSE;
+    glGetQueryObjectiv( frame.queries[ frame.number_of_queries - 1 ], GL_QUERY_RESULT_AVAILABLE, &available );
+    if ( available == GL_FALSE )
+    {
+        ++gpu_frames_not_ready;
+        return;
+    }
+    if ( frame.overflowed )
+    {
+        ++gpu_frames_overflowed;
+        return;
+    }
+
+    uint64_t pass_time[ GPU_PASS_COUNT ] = { 0 };
+    for ( int i = 0; i < frame.number_of_intervals; ++i )
+    {
+        const GpuTimerInterval& interval = frame.intervals[ i ];
+        if ( interval.end_query < 0 )
+        {
+            continue;
+        }
+        GLuint64 begin_time;
+        GLuint64 end_time;
+        glGetQueryObjectui64v( frame.queries[ interval.begin_query ], GL_QUERY_RESULT, &begin_time );
+        glGetQueryObjectui64v( frame.queries[ interval.end_query ], GL_QUERY_RESULT, &end_time );
+        pass_time[ interval.pass ] += end_time - begin_time;
+    }
+
+    for ( int pass = 0; pass < GPU_PASS_COUNT; ++pass )
+    {
+        gpu_pass_history[ pass ][ gpu_history_position ] = pass_time[ pass ];
+    }
+    gpu_history_position = ( gpu_history_position + 1 ) % CONFIG_GPU_TIMER_WINDOW;
+    gpu_history_frames = std::min( gpu_history_frames + 1, CONFIG_GPU_TIMER_WINDOW );
+#if CONFIG_FRAME_HISTOGRAM
+    frame_histogram_record( FRAME_CLOCK_GPU, pass_time[ GPU_PASS_FRAME ] / 1000000.0 );
+#endif
+}
+
+#endif
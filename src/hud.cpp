@@ -0,0 +1,178 @@
+#include "config.hpp"
+#include <algorithm>
+#include <cstdio>
+#include "glfw3.h"
+#include "hud.hpp"
+#include "palette.hpp"
+#include "rect.hpp"
+#include "render.hpp"
+#include "text.hpp"
+
+// dev/font_baker.py makes DEL a solid cell.
+#define HUD_SOLID_CHARACTER 127
+
+#define HUD_HISTORY 240
+#define HUD_GRAPH_FRAMES 64
+#define HUD_GRAPH_BAR_WIDTH 2
+#define HUD_GRAPH_HEIGHT 24
+#define HUD_GRAPH_MAX_MS 33.33f
+#define HUD_BUDGET_MS ( 1000.0f / 60.0f )
+#define HUD_LINES 4
+#define HUD_LINE_SIZE 64
+#define HUD_MARGIN 4
+#define HUD_PADDING 2
+
+// Glyph pixels are colour 1, so bank 1 draws them in colour 9.
+#define HUD_TEXT_PALETTE palette_make_id( 0, 1 )
+#define HUD_PANEL_PALETTE palette_make_id( 0, 0 )
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void hud_draw_box( float x, float y, float w, float h, int palette, float alpha );
+static float hud_get_frame_time( int frames_ago );
+static float hud_get_percentile( float percentile );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static Font hud_font = -1;
+static bool hud_visible = CONFIG_SHOW_HUD;
+
+// Frame times in ms, oldest overwritten first.
+static float frame_times[ HUD_HISTORY ];
+static int frame_time_position = 0;
+static int number_of_frame_times = 0;
+static double last_frame_start = -1.0;
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+bool hud_init()
+{
+    hud_font = text_load_font( "font" );
+    return hud_font >= 0;
+}
+
+void hud_set_visible( bool visible )
+{
+    hud_visible = visible;
+}
+
+void hud_toggle()
+{
+    hud_visible = !hud_visible;
+}
+
+bool hud_is_visible()
+{
+    return hud_visible;
+}
+
+void hud_draw()
+{
+    const double now = glfwGetTime();
+    if ( last_frame_start >= 0.0 )
+    {
+        frame_times[ frame_time_position ] = ( float )( ( now - last_frame_start ) * 1000.0 );
+        frame_time_position = ( frame_time_position + 1 ) % HUD_HISTORY;
+        number_of_frame_times = std::min( number_of_frame_times + 1, HUD_HISTORY );
+    }
+    last_frame_start = now;
+
+    if ( !hud_visible || hud_font < 0 )
+    {
+        return;
+    }
+
+    const RenderStats stats = render_get_stats();
+    char lines[ HUD_LINES ][ HUD_LINE_SIZE ];
+    snprintf( lines[ 0 ], HUD_LINE_SIZE, "FRAME %5.2f MS  P50 %5.2f  P99 %5.2f", hud_get_frame_time( 0 ), hud_get_percentile( 0.5f ), hud_get_percentile( 0.99f ) );
+    snprintf( lines[ 1 ], HUD_LINE_SIZE, "DRAWS %d  BATCHES %d  SPRITES %d  CULLED %d", stats.draw_calls, stats.batches, stats.sprites_submitted, stats.sprites_culled );
+    snprintf( lines[ 2 ], HUD_LINE_SIZE, "STATE %d SET %d SKIPPED  CPU %.2f MS", stats.state_changes, stats.state_changes_skipped, stats.cpu_submit_ms );
+    snprintf
+    (
+        lines[ 3 ],
+        HUD_LINE_SIZE,
+        "UPLOAD TEX %zu VTX %zu UNI %zu  VRAM %zuK",
+        stats.texture_bytes_uploaded,
+        stats.vertex_bytes_uploaded,
+        stats.uniform_bytes_uploaded,
+        stats.texture_bytes_resident / 1024
+    );
+
+    int width = HUD_GRAPH_FRAMES * HUD_GRAPH_BAR_WIDTH;
+    for ( const char* line : lines )
+    {
+        width = std::max( width, text_get_width( hud_font, line ) );
+    }
+    const float x = HUD_MARGIN + HUD_PADDING;
+    const float y = HUD_MARGIN + HUD_PADDING;
+    const int line_height = text_get_line_height( hud_font );
+    const float text_height = HUD_LINES * line_height;
+    hud_draw_box( HUD_MARGIN, HUD_MARGIN, width + HUD_PADDING * 2, text_height + HUD_PADDING + HUD_GRAPH_HEIGHT + HUD_PADDING * 2, HUD_PANEL_PALETTE, 0.5f );
+    for ( int line = 0; line < HUD_LINES; ++line )
+    {
+        text_draw( hud_font, lines[ line ], x, y + line * line_height, HUD_TEXT_PALETTE );
+    }
+
+    // Newest frame on the right; the faint line marks a 60 FPS budget.
+    const float graph_bottom = y + text_height + HUD_PADDING + HUD_GRAPH_HEIGHT;
+    const int bars = std::min( number_of_frame_times, HUD_GRAPH_FRAMES );
+    for ( int bar = 0; bar < bars; ++bar )
+    {
+        const float height = std::min( hud_get_frame_time( bar ) / HUD_GRAPH_MAX_MS, 1.0f ) * HUD_GRAPH_HEIGHT;
+        hud_draw_box( x + ( HUD_GRAPH_FRAMES - 1 - bar ) * HUD_GRAPH_BAR_WIDTH, graph_bottom - height, HUD_GRAPH_BAR_WIDTH, height, HUD_TEXT_PALETTE, 1.0f );
+    }
+    hud_draw_box( x, graph_bottom - HUD_BUDGET_MS / HUD_GRAPH_MAX_MS * HUD_GRAPH_HEIGHT, HUD_GRAPH_FRAMES * HUD_GRAPH_BAR_WIDTH, 1.0f, HUD_TEXT_PALETTE, 0.5f );
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+// Boxes stretch 1 pixel from the middle o’ the solid cell, so they share the text’s texture & batch.
+static void hud_draw_box( float x, float y, float w, float h, int palette, float alpha )
+{
+    const Rect cell = text_get_glyph( hud_font, HUD_SOLID_CHARACTER );
+    const Rect src = { cell.x + 1.0f, cell.y + 1.0f, 1.0f, 1.0f };
+    const Rect dest = { x, y, w, h };
+    render_texture( text_get_texture( hud_font ), src, dest, palette, false, false, 0.0f, alpha );
+}
+
+static float hud_get_frame_time( int frames_ago )
+{
+    if ( frames_ago >= number_of_frame_times )
+    {
+        return 0.0f;
+    }
+    return frame_times[ ( frame_time_position - 1 - frames_ago + HUD_HISTORY ) % HUD_HISTORY ];
+}
+
+static float hud_get_percentile( float percentile )
+{
+    if ( number_of_frame_times == 0 )
+    {
+        return 0.0f;
+    }
+    float sorted[ HUD_HISTORY ];
+    std::copy( frame_times, frame_times + number_of_frame_times, sorted );
+    float* nth = sorted + std::min( ( int )( percentile * number_of_frame_times ), number_of_frame_times - 1 );
+    std::nth_element( sorted, nth, sorted + number_of_frame_times );
+    return *nth;
+}
@@ -0,0 +1,425 @@
+#include "config.hpp"
+#include "load_bench.hpp"
+
+#if CONFIG_BENCH
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "render.hpp"
+
+#define MAX_LOAD_BENCH_FILES 128
+#define MAX_LOAD_BENCH_RESULTS 32
+#define MAX_LOAD_BENCH_NAME 31
+#define MAX_FILENAME 255
+#define BYTES_PER_MB ( 1024.0 * 1024.0 )
+#if CONFIG_NULL_GL
+#define LOAD_BENCH_BACKEND "null_gl"
+#define LOAD_BENCH_DIRECTORY "obj/bench/"
+#else
+#define LOAD_BENCH_BACKEND "gl"
+#define LOAD_BENCH_DIRECTORY "obj/bench-gl/"
+#endif
+#define LOAD_BENCH_CORPUS LOAD_BENCH_DIRECTORY "corpus/"
+
+// render_get_texture looks in bin/, so corpus names climb back out o’ it.
+#define LOAD_BENCH_TEXTURE_PREFIX "../" LOAD_BENCH_CORPUS
+
+struct LoadBenchClass
+{
+    const char* name;
+    int width;
+    int height;
+    int files;
+};
+
+enum LoadBenchPath
+{
+    LOAD_BENCH_COLD,
+    LOAD_BENCH_WARM,
+    LOAD_BENCH_READ_ONLY,
+    NUMBER_OF_LOAD_BENCH_PATHS
+};
+
+// read_syscalls is -1 where /proc/self/io isn’t there to count them.
+struct LoadBenchResult
+{
+    char path[ MAX_LOAD_BENCH_NAME + 1 ];
+    char size_class[ MAX_LOAD_BENCH_NAME + 1 ];
+    int files;
+    long long bytes;
+    double mb_per_s;
+    double p50_ms;
+    double p95_ms;
+    double max_ms;
+    long long read_syscalls;
+    double read_ms;
+    double decode_ms;
+    double upload_ms;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static bool load_bench_write_corpus( const char* set, bool drop_from_cache );
+static bool load_bench_measure( const LoadBenchClass& size_class, LoadBenchPath path, LoadBenchResult& result );
+static bool load_bench_read_only( const char* filename );
+static long long load_bench_get_read_syscalls();
+static const LoadBenchResult* load_bench_find( const LoadBenchResult* results, int number_of_results, const char* path, const char* size_class );
+static int load_bench_read_csv( const char* filename, LoadBenchResult* results, int max_results );
+static bool load_bench_write_csv( const char* filename, const LoadBenchResult* results, int number_of_results );
+static bool load_bench_write_json( const char* filename, const LoadBenchResult* results, int number_of_results );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const LoadBenchClass load_bench_classes[] =
+{
+    { "sprite", 16, 16, 128 },
+    { "sheet", 128, 128, 32 },
+    { "page", 512, 512, 8 },
+    { "background", 1024, 1024, 2 },
+    { "large", 2048, 2048, 1 }
+};
+
+// The cold & warm sets are the same images under different names, as a name only ever loads once.
+static const char* load_bench_path_names[ NUMBER_OF_LOAD_BENCH_PATHS ] = { "cold", "warm", "read_only" };
+static const char* load_bench_path_sets[ NUMBER_OF_LOAD_BENCH_PATHS ] = { "cold", "warm", "warm" };
+
+static double file_latencies[ MAX_LOAD_BENCH_FILES ];
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+int load_bench_run( const char* baseline_filename )
+{
+    if ( !load_bench_write_corpus( "warm", false ) || !load_bench_write_corpus( "cold", true ) )
+    {
+        return -1;
+    }
+
+    static LoadBenchResult baseline[ MAX_LOAD_BENCH_RESULTS ];
+    const int number_of_baseline_results = ( baseline_filename ) ? load_bench_read_csv( baseline_filename, baseline, MAX_LOAD_BENCH_RESULTS ) : 0;
+
+    static LoadBenchResult results[ MAX_LOAD_BENCH_RESULTS ];
+    int number_of_results = 0;
+    printf
+    (
+        "%-10s %-11s %5s %8s %9s %8s %8s %8s %7s %9s %9s %9s %8s\n",
+        "path", "class", "files", "MB", "MB/s", "p50 ms", "p95 ms", "max ms", "reads", "read ms", "decode ms", "upload ms", "vs base"
+    );
+    for ( int path = 0; path < NUMBER_OF_LOAD_BENCH_PATHS; ++path )
+    {
+        for ( const LoadBenchClass& size_class : load_bench_classes )
+        {
+            if ( number_of_results == MAX_LOAD_BENCH_RESULTS )
+            {
+                break;
+            }
+            LoadBenchResult& result = results[ number_of_results ];
+            if ( !load_bench_measure( size_class, ( LoadBenchPath )( path ), result ) )
+            {
+                return -1;
+            }
+            ++number_of_results;
+
+            char change[ 32 ] = "";
+            const LoadBenchResult* base = load_bench_find( baseline, number_of_baseline_results, result.path, result.size_class );
+            if ( base && base->mb_per_s > 0.0 )
+            {
+                snprintf( change, sizeof( change ), "%+.1f%%", ( result.mb_per_s / base->mb_per_s - 1.0 ) * 100.0 );
+            }
+            printf
+            (
+                "%-10s %-11s %5d %8.2f %9.1f %8.3f %8.3f %8.3f %7lld %9.2f %9.2f %9.2f %8s\n",
+                result.path, result.size_class, result.files, result.bytes / BYTES_PER_MB, result.mb_per_s, result.p50_ms, result.p95_ms, result.max_ms,
+                result.read_syscalls, result.read_ms, result.decode_ms, result.upload_ms, change
+            );
+        }
+    }
+
+    const bool written = load_bench_write_csv( LOAD_BENCH_DIRECTORY "loading.csv", results, number_of_results )
+        && load_bench_write_json( LOAD_BENCH_DIRECTORY "loading.json", results, number_of_results );
+    if ( written )
+    {
+        printf( "Bench: results written to " LOAD_BENCH_DIRECTORY "loading.csv & .json.\n" );
+    }
+    return ( written ) ? 0 : -1;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+// Images are blocky patterns o’ the first 32 colours, so nothing about them is cheaper to load than real art.
+// Dropping files from the page cache is only advice; dirty pages are written out first so it can be taken.
+static bool load_bench_write_corpus( const char* set, bool drop_from_cache )
+{
+    char directory[ MAX_FILENAME + 1 ];
+    snprintf( directory, sizeof( directory ), LOAD_BENCH_CORPUS "%s/", set );
+    mkdir( LOAD_BENCH_CORPUS, 0755 );
+    mkdir( directory, 0755 );
+
+    for ( const LoadBenchClass& size_class : load_bench_classes )
+    {
+        const size_t image_size = ( size_t )( size_class.width * size_class.height );
+        unsigned char* data = ( unsigned char* )( malloc( 4 + image_size ) );
+        if ( !data )
+        {
+            printf( "Bench: out o’ memory writing the corpus.\n" );
+            return false;
+        }
+        data[ 0 ] = ( unsigned char )( size_class.width >> 8 );
+        data[ 1 ] = ( unsigned char )( size_class.width );
+        data[ 2 ] = ( unsigned char )( size_class.height >> 8 );
+        data[ 3 ] = ( unsigned char )( size_class.height );
+
+        for ( int file_number = 0; file_number < size_class.files; ++file_number )
+        {
+            for ( int y = 0; y < size_class.height; ++y )
+            {
+                for ( int x = 0; x < size_class.width; ++x )
+                {
+                    data[ 4 + y * size_class.width + x ] = ( unsigned char )( ( ( x >> 2 ) ^ ( y >> 2 ) ^ file_number ) & 31 );
+                }
+            }
+
+            char filename[ MAX_FILENAME * 2 ];
+            snprintf( filename, sizeof( filename ), "%s%s_%d.jwi", directory, size_class.name, file_number );
+            FILE* file = fopen( filename, "wb" );
+            const bool written = file && fwrite( data, 1, 4 + image_size, file ) == 4 + image_size && fflush( file ) == 0;
+            if ( file && written && drop_from_cache )
+            {
+                fdatasync( fileno( file ) );
+                posix_fadvise( fileno( file ), 0, 0, POSIX_FADV_DONTNEED );
+            }
+            if ( file )
+            {
+                fclose( file );
+            }
+            if ( !written )
+            {
+                printf( "Bench: couldn’t write %s\n", filename );
+                free( data );
+                return false;
+            }
+        }
+        free( data );
+    }
+    return true;
+}
+
+static bool load_bench_measure( const LoadBenchClass& size_class, LoadBenchPath path, LoadBenchResult& result )
+{
+    result = {};
+    snprintf( result.path, sizeof( result.path ), "%s", load_bench_path_names[ path ] );
+    snprintf( result.size_class, sizeof( result.size_class ), "%s", size_class.name );
+    result.files = std::min( size_class.files, MAX_LOAD_BENCH_FILES );
+    result.bytes = ( long long )( result.files ) * ( 4 + size_class.width * size_class.height );
+
+    const long long syscalls_before = load_bench_get_read_syscalls();
+    const RenderLoadStats stats_before = render_get_load_stats();
+    double total_ms = 0.0;
+    for ( int file_number = 0; file_number < result.files; ++file_number )
+    {
+        char name[ MAX_FILENAME + 1 ];
+        snprintf( name, sizeof( name ), LOAD_BENCH_TEXTURE_PREFIX "%s/%s_%d", load_bench_path_sets[ path ], size_class.name, file_number );
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool loaded;
+        if ( path == LOAD_BENCH_READ_ONLY )
+        {
+            char filename[ MAX_FILENAME + 9 ];
+            snprintf( filename, sizeof( filename ), "bin/%s.jwi", name );
+            loaded = load_bench_read_only( filename );
+        }
+        else
+        {
+            loaded = render_get_texture( name ) >= 0;
+        }
+        file_latencies[ file_number ] = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        total_ms += file_latencies[ file_number ];
+        if ( !loaded )
+        {
+            printf( "Bench: couldn’t load %s\n", name );
+            return false;
+        }
+    }
+    const long long syscalls_after = load_bench_get_read_syscalls();
+    const RenderLoadStats stats_after = render_get_load_stats();
+
+    std::sort( file_latencies, file_latencies + result.files );
+    result.mb_per_s = ( total_ms > 0.0 ) ? result.bytes / BYTES_PER_MB / ( total_ms / 1000.0 ) : 0.0;
+    result.p50_ms = file_latencies[ std::min( result.files - 1, result.files / 2 ) ];
+    result.p95_ms = file_latencies[ std::min( result.files - 1, result.files * 95 / 100 ) ];
+    result.max_ms = file_latencies[ result.files - 1 ];
+    result.read_syscalls = ( syscalls_before >= 0 && syscalls_after >= 0 ) ? syscalls_after - syscalls_before : -1;
+    result.read_ms = ( path == LOAD_BENCH_READ_ONLY ) ? total_ms : stats_after.read_ms - stats_before.read_ms;
+    result.decode_ms = stats_after.decode_ms - stats_before.decode_ms;
+    result.upload_ms = stats_after.upload_ms - stats_before.upload_ms;
+    return true;
+}
+
+// The least a loader could do: one open, one fstat & as few reads as the OS allows.
+static bool load_bench_read_only( const char* filename )
+{
+    const int file = open( filename, O_RDONLY );
+    if ( file < 0 )
+    {
+        return false;
+    }
+    struct stat file_status;
+    if ( fstat( file, &file_status ) != 0 )
+    {
+        close( file );
+        return false;
+    }
+
+    const size_t file_size = ( size_t )( file_status.st_size );
+    unsigned char* buffer = ( unsigned char* )( malloc( file_size ) );
+    size_t bytes_read = 0;
+    while ( buffer && bytes_read < file_size )
+    {
+        const ssize_t count = read( file, buffer + bytes_read, file_size - bytes_read );
+        if ( count <= 0 )
+        {
+            break;
+        }
+        bytes_read += ( size_t )( count );
+    }
+    close( file );
+    free( buffer );
+    return buffer && bytes_read == file_size;
+}
+
+static long long load_bench_get_read_syscalls()
+{
+    FILE* file = fopen( "/proc/self/io", "r" );
+    if ( !file )
+    {
+        return -1;
+    }
+
+    long long syscalls = -1;
+    char line[ 128 ];
+    while ( fgets( line, sizeof( line ), file ) )
+    {
+        if ( sscanf( line, "syscr: %lld", &syscalls ) == 1 )
+        {
+            break;
+        }
+    }
+    fclose( file );
+    return syscalls;
+}
+
+static const LoadBenchResult* load_bench_find( const LoadBenchResult* results, int number_of_results, const char* path, const char* size_class )
+{
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        if ( strcmp( results[ result ].path, path ) == 0 && strcmp( results[ result ].size_class, size_class ) == 0 )
+        {
+            return &results[ result ];
+        }
+    }
+    return nullptr;
+}
+
+static int load_bench_read_csv( const char* filename, LoadBenchResult* results, int max_results )
+{
+    FILE* file = fopen( filename, "r" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t open baseline %s\n", filename );
+        return 0;
+    }
+
+    int number_of_results = 0;
+    char line[ 256 ];
+    while ( number_of_results < max_results && fgets( line, sizeof( line ), file ) )
+    {
+        LoadBenchResult& r = results[ number_of_results ];
+        // The header & anything else that isn’t a result fails to scan & is skipped.
+        if
+        (
+            sscanf
+            (
+                line, "%31[^,],%31[^,],%d,%lld,%lf,%lf,%lf,%lf,%lld,%lf,%lf,%lf",
+                r.path, r.size_class, &r.files, &r.bytes, &r.mb_per_s, &r.p50_ms, &r.p95_ms, &r.max_ms, &r.read_syscalls, &r.read_ms, &r.decode_ms, &r.upload_ms
+            ) == 12
+        )
+        {
+            ++number_of_results;
+        }
+    }
+    fclose( file );
+    return number_of_results;
+}
+
+static bool load_bench_write_csv( const char* filename, const LoadBenchResult* results, int number_of_results )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t write %s\n", filename );
+        return false;
+    }
+    fprintf( file, "path,class,files,bytes,mb_per_s,p50_ms,p95_ms,max_ms,read_syscalls,read_ms,decode_ms,upload_ms\n" );
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        const LoadBenchResult& r = results[ result ];
+        fprintf
+        (
+            file, "%s,%s,%d,%lld,%f,%f,%f,%f,%lld,%f,%f,%f\n",
+            r.path, r.size_class, r.files, r.bytes, r.mb_per_s, r.p50_ms, r.p95_ms, r.max_ms, r.read_syscalls, r.read_ms, r.decode_ms, r.upload_ms
+        );
+    }
+    fclose( file );
+    return true;
+}
+
+static bool load_bench_write_json( const char* filename, const LoadBenchResult* results, int number_of_results )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( !file )
+    {
+        printf( "Bench: couldn’t write %s\n", filename );
+        return false;
+    }
+    fprintf( file, "{\n  \"backend\": \"%s\",\n  \"results\": [\n", LOAD_BENCH_BACKEND );
+    for ( int result = 0; result < number_of_results; ++result )
+    {
+        const LoadBenchResult& r = results[ result ];
+        fprintf
+        (
+            file,
+            "    { \"path\": \"%s\", \"class\": \"%s\", \"files\": %d, \"bytes\": %lld, \"mb_per_s\": %f, \"p50_ms\": %f, \"p95_ms\": %f, \"max_ms\": %f, "
+            "\"read_syscalls\": %lld, \"read_ms\": %f, \"decode_ms\": %f, \"upload_ms\": %f }%s\n",
+            r.path, r.size_class, r.files, r.bytes, r.mb_per_s, r.p50_ms, r.p95_ms, r.max_ms, r.read_syscalls, r.read_ms, r.decode_ms, r.upload_ms,
+            ( result + 1 < number_of_results ) ? "," : ""
+        );
+    }
+    fprintf( file, "  ]\n}\n" );
+    fclose( file );
+    return true;
+}
+#endif
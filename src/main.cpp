@@ -1,8 +1,18 @@
 #include "config.hpp"
 #include <cstdio>
+#include <cstring>
+#include "bench.hpp"
+#include "frame_histogram.hpp"
 #include "game.hpp"
 #include "glad.h"
 #include "glfw3.h"
+#include "golden.hpp"
+#include "gpu_timer.hpp"
+#include "hud.hpp"
+#include "load_bench.hpp"
+#include "null_gl.hpp"
+#include "palette.hpp"
+#include "profiler.hpp"
 #include "rect.hpp"
 #include "render.hpp"
 #include "texture.hpp"
@@ -15,29 +25,88 @@ int main( int argc, char** argv )
         return -1;
     }
 
+#if CONFIG_GOLDEN
+    const int golden_failures = golden_run( argc > 1 && strcmp( argv[ 1 ], "--update" ) == 0 );
+    game_close();
+    return ( golden_failures == 0 ) ? 0 : 1;
+#endif
+#if CONFIG_BENCH
+    const bool loading = argc > 1 && strcmp( argv[ 1 ], "--load" ) == 0;
+    const int first_option = ( loading ) ? 2 : 1;
+    const char* baseline = ( argc > first_option + 1 && strcmp( argv[ first_option ], "--baseline" ) == 0 ) ? argv[ first_option + 1 ] : nullptr;
+    const int bench_result = ( loading ) ? load_bench_run( baseline ) : bench_run( baseline );
+    game_close();
+    return ( bench_result == 0 ) ? 0 : 1;
+#endif
+
     const Rect autumn_dest_rect = { 128.0f, 96.0f, 16.0f, 25.0f };
     const Rect autumn_src_rect = { 0.0f, 0.0f, 16.0f, 25.0f };
     const Rect hydrant_dest_rect = { 192.0f, 32.0f, 16.0f, 16.0f };
     const Rect hydrant_src_rect = { 16.0f, 16.0f, 16.0f, 16.0f };
+    palette_load( "palettes" );
+    render_load_atlas( "sprites" );
     //Texture autumn_texture = render_get_texture( "autumn" );
     Texture hydrant_texture = render_get_texture( "hydrant" );
+    hud_init();
+
+    if ( CONFIG_SHOW_MEMORY_REPORT )
+    {
+        render_print_memory_report();
+    }
 
     float rotation = 0.0f;
+    bool hud_key_was_down = false;
+#if CONFIG_FRAME_HISTOGRAM
+    bool histogram_key_was_down = false;
+#endif
 
     while ( !render_window_closed() )
     {
+        palette_update();
         render_start();
         //render_rect( hydrant_dest_rect, 2 );
         //render_texture( autumn_texture, autumn_src_rect, autumn_dest_rect, 0 );
         render_texture( hydrant_texture, hydrant_src_rect, hydrant_dest_rect, 1 );
+        hud_draw();
         render_present();
 
         rotation += 1.0f;
 
         /* Poll for and process events */
-        glfwPollEvents();
+        {
+            PROFILE_ZONE( "glfwPollEvents" );
+            glfwPollEvents();
+        }
+        const bool hud_key_down = glfwGetKey( glfwGetCurrentContext(), GLFW_KEY_F3 ) == GLFW_PRESS;
+        if ( hud_key_down && !hud_key_was_down )
+        {
+            hud_toggle();
+        }
+        hud_key_was_down = hud_key_down;
+
+#if CONFIG_FRAME_HISTOGRAM
+        const bool histogram_key_down = glfwGetKey( glfwGetCurrentContext(), GLFW_KEY_F4 ) == GLFW_PRESS;
+        if ( histogram_key_down && !histogram_key_was_down )
+        {
+            frame_histogram_print_report();
+        }
+        histogram_key_was_down = histogram_key_down;
+#endif
     }
 
+#if CONFIG_GPU_TIMERS
+    gpu_timer_print_report();
+#endif
+#if CONFIG_FRAME_HISTOGRAM
+    frame_histogram_print_report();
+#endif
+#if CONFIG_NULL_GL
+    null_gl_print_report();
+#endif
+#if CONFIG_PROFILER
+    profiler_export_chrome_trace( "bin/trace.json", CONFIG_PROFILER_EXPORT_FRAMES );
+#endif
+
     game_close();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,908 @@
+#include "config.hpp"
+#include "null_gl.hpp"
+
+#if CONFIG_NULL_GL
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "glad.h"
+#include "glfw3.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#define NULL_GL_RECORDING_SIZE 4096
+#define MAX_NULL_GL_SHADERS 64
+#define MAX_NULL_GL_PROGRAMS 64
+#define MAX_NULL_GL_UNIFORMS 32
+#define MAX_NULL_GL_UNIFORM_NAME 64
+
+static_assert( ( NULL_GL_RECORDING_SIZE & ( NULL_GL_RECORDING_SIZE - 1 ) ) == 0, "Null GL recording size must be a power o’ 2." );
+
+// Every GL function the engine calls. Anything else glad loads gets null_gl_ignored, counted as NULL_GL_OTHER.
+enum NullGlFunction
+{
+    NULL_GL_ACTIVE_TEXTURE,
+    NULL_GL_ATTACH_SHADER,
+    NULL_GL_BIND_BUFFER,
+    NULL_GL_BIND_FRAMEBUFFER,
+    NULL_GL_BIND_TEXTURE,
+    NULL_GL_BIND_VERTEX_ARRAY,
+    NULL_GL_BLEND_FUNC,
+    NULL_GL_BUFFER_DATA,
+    NULL_GL_BUFFER_SUB_DATA,
+    NULL_GL_CHECK_FRAMEBUFFER_STATUS,
+    NULL_GL_CLEAR,
+    NULL_GL_CLEAR_COLOR,
+    NULL_GL_COMPILE_SHADER,
+    NULL_GL_CREATE_PROGRAM,
+    NULL_GL_CREATE_SHADER,
+    NULL_GL_DELETE_PROGRAM,
+    NULL_GL_DELETE_SHADER,
+    NULL_GL_DISABLE,
+    NULL_GL_DRAW_ELEMENTS,
+    NULL_GL_ENABLE,
+    NULL_GL_ENABLE_VERTEX_ATTRIB_ARRAY,
+    NULL_GL_FRAMEBUFFER_TEXTURE_2D,
+    NULL_GL_GEN_BUFFERS,
+    NULL_GL_GEN_FRAMEBUFFERS,
+    NULL_GL_GEN_QUERIES,
+    NULL_GL_GEN_TEXTURES,
+    NULL_GL_GEN_VERTEX_ARRAYS,
+    NULL_GL_GET_ACTIVE_UNIFORM,
+    NULL_GL_GET_ERROR,
+    NULL_GL_GET_INTEGERV,
+    NULL_GL_GET_PROGRAM_INFO_LOG,
+    NULL_GL_GET_PROGRAMIV,
+    NULL_GL_GET_QUERY_OBJECTIV,
+    NULL_GL_GET_QUERY_OBJECTUI64V,
+    NULL_GL_GET_SHADER_INFO_LOG,
+    NULL_GL_GET_SHADERIV,
+    NULL_GL_GET_STRING,
+    NULL_GL_GET_STRINGI,
+    NULL_GL_GET_UNIFORM_LOCATION,
+    NULL_GL_LINK_PROGRAM,
+    NULL_GL_PIXEL_STOREI,
+    NULL_GL_QUERY_COUNTER,
+    NULL_GL_SHADER_SOURCE,
+    NULL_GL_TEX_IMAGE_2D,
+    NULL_GL_TEX_PARAMETERI,
+    NULL_GL_TEX_SUB_IMAGE_2D,
+    NULL_GL_UNIFORM_1F,
+    NULL_GL_UNIFORM_1I,
+    NULL_GL_UNIFORM_4FV,
+    NULL_GL_UNIFORM_MATRIX_4FV,
+    NULL_GL_USE_PROGRAM,
+    NULL_GL_VERTEX_ATTRIB_I_POINTER,
+    NULL_GL_VERTEX_ATTRIB_POINTER,
+    NULL_GL_VIEWPORT,
+    NULL_GL_OTHER,
+    NULL_GL_FUNCTION_COUNT
+};
+
+struct NullGlEntry
+{
+    const char* name;
+    void* function;
+};
+
+// Uniform names are all a shader needs to be reflected.
+struct NullGlShader
+{
+    GLuint id;
+    int number_of_uniforms;
+    char uniforms[ MAX_NULL_GL_UNIFORMS ][ MAX_NULL_GL_UNIFORM_NAME ];
+};
+
+struct NullGlProgram
+{
+    GLuint id;
+    GLuint shaders[ 2 ];
+    int number_of_shaders;
+    int number_of_uniforms;
+    char uniforms[ MAX_NULL_GL_UNIFORMS ][ MAX_NULL_GL_UNIFORM_NAME ];
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void null_gl_record( NullGlFunction function, unsigned int argument );
+static void null_gl_generate( NullGlFunction function, GLsizei count, GLuint* ids );
+static size_t null_gl_get_pixel_size( GLenum format, GLenum type );
+static NullGlShader* null_gl_find_shader( GLuint id );
+static NullGlProgram* null_gl_find_program( GLuint id );
+static void null_gl_add_uniform( char ( *uniforms )[ MAX_NULL_GL_UNIFORM_NAME ], int* number_of_uniforms, const char* name, size_t length );
+static void null_gl_scan_uniforms( NullGlShader& shader, const char* source, size_t length );
+
+static void APIENTRY null_gl_active_texture( GLenum texture );
+static void APIENTRY null_gl_attach_shader( GLuint program, GLuint shader );
+static void APIENTRY null_gl_bind_buffer( GLenum target, GLuint buffer );
+static void APIENTRY null_gl_bind_framebuffer( GLenum target, GLuint framebuffer );
+static void APIENTRY null_gl_bind_texture( GLenum target, GLuint texture );
+static void APIENTRY null_gl_bind_vertex_array( GLuint array );
+static void APIENTRY null_gl_blend_func( GLenum source, GLenum destination );
+static void APIENTRY null_gl_buffer_data( GLenum target, GLsizeiptr size, const void* data, GLenum usage );
+static void APIENTRY null_gl_buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void* data );
+static GLenum APIENTRY null_gl_check_framebuffer_status( GLenum target );
+static void APIENTRY null_gl_clear( GLbitfield mask );
+static void APIENTRY null_gl_clear_color( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+static void APIENTRY null_gl_compile_shader( GLuint shader );
+static GLuint APIENTRY null_gl_create_program();
+static GLuint APIENTRY null_gl_create_shader( GLenum type );
+static void APIENTRY null_gl_delete_program( GLuint program );
+static void APIENTRY null_gl_delete_shader( GLuint shader );
+static void APIENTRY null_gl_disable( GLenum capability );
+static void APIENTRY null_gl_draw_elements( GLenum mode, GLsizei count, GLenum type, const void* indices );
+static void APIENTRY null_gl_enable( GLenum capability );
+static void APIENTRY null_gl_enable_vertex_attrib_array( GLuint index );
+static void APIENTRY null_gl_framebuffer_texture_2d( GLenum target, GLenum attachment, GLenum texture_target, GLuint texture, GLint level );
+static void APIENTRY null_gl_gen_buffers( GLsizei count, GLuint* buffers );
+static void APIENTRY null_gl_gen_framebuffers( GLsizei count, GLuint* framebuffers );
+static void APIENTRY null_gl_gen_queries( GLsizei count, GLuint* queries );
+static void APIENTRY null_gl_gen_textures( GLsizei count, GLuint* textures );
+static void APIENTRY null_gl_gen_vertex_arrays( GLsizei count, GLuint* arrays );
+static void APIENTRY null_gl_get_active_uniform( GLuint program, GLuint index, GLsizei buffer_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name );
+static GLenum APIENTRY null_gl_get_error();
+static void APIENTRY null_gl_get_integerv( GLenum name, GLint* data );
+static void APIENTRY null_gl_get_program_info_log( GLuint program, GLsizei buffer_size, GLsizei* length, GLchar* log );
+static void APIENTRY null_gl_get_programiv( GLuint program, GLenum name, GLint* parameter );
+static void APIENTRY null_gl_get_query_objectiv( GLuint query, GLenum name, GLint* parameter );
+static void APIENTRY null_gl_get_query_objectui64v( GLuint query, GLenum name, GLuint64* parameter );
+static void APIENTRY null_gl_get_shader_info_log( GLuint shader, GLsizei buffer_size, GLsizei* length, GLchar* log );
+static void APIENTRY null_gl_get_shaderiv( GLuint shader, GLenum name, GLint* parameter );
+static const GLubyte* APIENTRY null_gl_get_string( GLenum name );
+static const GLubyte* APIENTRY null_gl_get_stringi( GLenum name, GLuint index );
+static GLint APIENTRY null_gl_get_uniform_location( GLuint program, const GLchar* name );
+static void APIENTRY null_gl_link_program( GLuint program );
+static void APIENTRY null_gl_pixel_storei( GLenum name, GLint parameter );
+static void APIENTRY null_gl_query_counter( GLuint query, GLenum target );
+static void APIENTRY null_gl_shader_source( GLuint shader, GLsizei count, const GLchar* const* source, const GLint* length );
+static void APIENTRY null_gl_tex_image_2d( GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels );
+static void APIENTRY null_gl_tex_parameteri( GLenum target, GLenum name, GLint parameter );
+static void APIENTRY null_gl_tex_sub_image_2d( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels );
+static void APIENTRY null_gl_uniform_1f( GLint location, GLfloat value );
+static void APIENTRY null_gl_uniform_1i( GLint location, GLint value );
+static void APIENTRY null_gl_uniform_4fv( GLint location, GLsizei count, const GLfloat* value );
+static void APIENTRY null_gl_uniform_matrix_4fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value );
+static void APIENTRY null_gl_use_program( GLuint program );
+static void APIENTRY null_gl_vertex_attrib_i_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer );
+static void APIENTRY null_gl_vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer );
+static void APIENTRY null_gl_viewport( GLint x, GLint y, GLsizei width, GLsizei height );
+static void APIENTRY null_gl_ignored();
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+// In NullGlFunction order, so a function’s entry also names it in reports.
+static const NullGlEntry null_gl_entries[ NULL_GL_FUNCTION_COUNT ] =
+{
+    { "glActiveTexture", ( void* )( null_gl_active_texture ) },
+    { "glAttachShader", ( void* )( null_gl_attach_shader ) },
+    { "glBindBuffer", ( void* )( null_gl_bind_buffer ) },
+    { "glBindFramebuffer", ( void* )( null_gl_bind_framebuffer ) },
+    { "glBindTexture", ( void* )( null_gl_bind_texture ) },
+    { "glBindVertexArray", ( void* )( null_gl_bind_vertex_array ) },
+    { "glBlendFunc", ( void* )( null_gl_blend_func ) },
+    { "glBufferData", ( void* )( null_gl_buffer_data ) },
+    { "glBufferSubData", ( void* )( null_gl_buffer_sub_data ) },
+    { "glCheckFramebufferStatus", ( void* )( null_gl_check_framebuffer_status ) },
+    { "glClear", ( void* )( null_gl_clear ) },
+    { "glClearColor", ( void* )( null_gl_clear_color ) },
+    { "glCompileShader", ( void* )( null_gl_compile_shader ) },
+    { "glCreateProgram", ( void* )( null_gl_create_program ) },
+    { "glCreateShader", ( void* )( null_gl_create_shader ) },
+    { "glDeleteProgram", ( void* )( null_gl_delete_program ) },
+    { "glDeleteShader", ( void* )( null_gl_delete_shader ) },
+    { "glDisable", ( void* )( null_gl_disable ) },
+    { "glDrawElements", ( void* )( null_gl_draw_elements ) },
+    { "glEnable", ( void* )( null_gl_enable ) },
+    { "glEnableVertexAttribArray", ( void* )( null_gl_enable_vertex_attrib_array ) },
+    { "glFramebufferTexture2D", ( void* )( null_gl_framebuffer_texture_2d ) },
+    { "glGenBuffers", ( void* )( null_gl_gen_buffers ) },
+    { "glGenFramebuffers", ( void* )( null_gl_gen_framebuffers ) },
+    { "glGenQueries", ( void* )( null_gl_gen_queries ) },
+    { "glGenTextures", ( void* )( null_gl_gen_textures ) },
+    { "glGenVertexArrays", ( void* )( null_gl_gen_vertex_arrays ) },
+    { "glGetActiveUniform", ( void* )( null_gl_get_active_uniform ) },
+    { "glGetError", ( void* )( null_gl_get_error ) },
+    { "glGetIntegerv", ( void* )( null_gl_get_integerv ) },
+    { "glGetProgramInfoLog", ( void* )( null_gl_get_program_info_log ) },
+    { "glGetProgramiv", ( void* )( null_gl_get_programiv ) },
+    { "glGetQueryObjectiv", ( void* )( null_gl_get_query_objectiv ) },
+    { "glGetQueryObjectui64v", ( void* )( null_gl_get_query_objectui64v ) },
+    { "glGetShaderInfoLog", ( void* )( null_gl_get_shader_info_log ) },
+    { "glGetShaderiv", ( void* )( null_gl_get_shaderiv ) },
+    { "glGetString", ( void* )( null_gl_get_string ) },
+    { "glGetStringi", ( void* )( null_gl_get_stringi ) },
+    { "glGetUniformLocation", ( void* )( null_gl_get_uniform_location ) },
+    { "glLinkProgram", ( void* )( null_gl_link_program ) },
+    { "glPixelStorei", ( void* )( null_gl_pixel_storei ) },
+    { "glQueryCounter", ( void* )( null_gl_query_counter ) },
+    { "glShaderSource", ( void* )( null_gl_shader_source ) },
+    { "glTexImage2D", ( void* )( null_gl_tex_image_2d ) },
+    { "glTexParameteri", ( void* )( null_gl_tex_parameteri ) },
+    { "glTexSubImage2D", ( void* )( null_gl_tex_sub_image_2d ) },
+    { "glUniform1f", ( void* )( null_gl_uniform_1f ) },
+    { "glUniform1i", ( void* )( null_gl_uniform_1i ) },
+    { "glUniform4fv", ( void* )( null_gl_uniform_4fv ) },
+    { "glUniformMatrix4fv", ( void* )( null_gl_uniform_matrix_4fv ) },
+    { "glUseProgram", ( void* )( null_gl_use_program ) },
+    { "glVertexAttribIPointer", ( void* )( null_gl_vertex_attrib_i_pointer ) },
+    { "glVertexAttribPointer", ( void* )( null_gl_vertex_attrib_pointer ) },
+    { "glViewport", ( void* )( null_gl_viewport ) },
+    { "other", ( void* )( null_gl_ignored ) }
+};
+
+static NullGlStats null_gl_stats = {};
+static uint64_t null_gl_counts[ NULL_GL_FUNCTION_COUNT ] = {};
+static NullGlRecord null_gl_recording[ NULL_GL_RECORDING_SIZE ];
+static uint64_t null_gl_recording_position = 0;
+
+static GLuint null_gl_next_id = 1;
+static NullGlShader null_gl_shaders[ MAX_NULL_GL_SHADERS ];
+static NullGlProgram null_gl_programs[ MAX_NULL_GL_PROGRAMS ];
+
+// GLFW only has to hand out one window, which needs an address but no contents.
+static int null_window;
+static const std::chrono::steady_clock::time_point null_start_time = std::chrono::steady_clock::now();
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void* null_gl_get_proc_address( const char* name )
+{
+    for ( const NullGlEntry& entry : null_gl_entries )
+    {
+        if ( strcmp( entry.name, name ) == 0 )
+        {
+            return entry.function;
+        }
+    }
+
+    // Called through the wrong pointer type, but it takes nothing & returns nothing, which the calling
+    // conventions we build for tolerate. The engine ne’er calls these anyway; glad just wants them non-null.
+    return ( void* )( null_gl_ignored );
+}
+
+NullGlStats null_gl_get_stats()
+{
+    return null_gl_stats;
+}
+
+void null_gl_reset_stats()
+{
+    const uint64_t frames = null_gl_stats.frames;
+    null_gl_stats = {};
+    null_gl_stats.frames = frames;
+    std::fill( null_gl_counts, null_gl_counts + NULL_GL_FUNCTION_COUNT, 0 );
+}
+
+int null_gl_get_recording( NullGlRecord* records, int max_records )
+{
+    const uint64_t available = std::min( null_gl_recording_position, ( uint64_t )( NULL_GL_RECORDING_SIZE ) );
+    const int count = ( int )( std::min( available, ( uint64_t )( std::max( max_records, 0 ) ) ) );
+    for ( int i = 0; i < count; ++i )
+    {
+        records[ i ] = null_gl_recording[ ( null_gl_recording_position - count + i ) & ( NULL_GL_RECORDING_SIZE - 1 ) ];
+    }
+    return count;
+}
+
+const char* null_gl_get_function_name( int function )
+{
+    return ( function >= 0 && function < NULL_GL_FUNCTION_COUNT ) ? null_gl_entries[ function ].name : "unknown";
+}
+
+void null_gl_print_report()
+{
+    printf
+    (
+        "Null GL: %llu calls over %llu frames, %llu draws, %llu texture bytes & %llu buffer bytes uploaded.\n",
+        ( unsigned long long )( null_gl_stats.calls ),
+        ( unsigned long long )( null_gl_stats.frames ),
+        ( unsigned long long )( null_gl_stats.draw_calls ),
+        ( unsigned long long )( null_gl_stats.texture_bytes ),
+        ( unsigned long long )( null_gl_stats.buffer_bytes )
+    );
+    for ( int function = 0; function < NULL_GL_FUNCTION_COUNT; ++function )
+    {
+        if ( null_gl_counts[ function ] > 0 )
+        {
+            printf( "  %-26s %10llu\n", null_gl_entries[ function ].name, ( unsigned long long )( null_gl_counts[ function ] ) );
+        }
+    }
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static void null_gl_record( NullGlFunction function, unsigned int argument )
+{
+    ++null_gl_stats.calls;
+    ++null_gl_counts[ function ];
+    null_gl_recording[ null_gl_recording_position++ & ( NULL_GL_RECORDING_SIZE - 1 ) ] = { function, argument };
+}
+
+static void null_gl_generate( NullGlFunction function, GLsizei count, GLuint* ids )
+{
+    null_gl_record( function, ( unsigned int )( count ) );
+    for ( GLsizei i = 0; i < count; ++i )
+    {
+        ids[ i ] = null_gl_next_id++;
+    }
+}
+
+static size_t null_gl_get_pixel_size( GLenum format, GLenum type )
+{
+    const size_t channels = ( format == GL_RGBA ) ? 4 : ( format == GL_RGB ) ? 3 : ( format == GL_RG ) ? 2 : 1;
+    return channels * ( ( type == GL_FLOAT ) ? 4 : 1 );
+}
+
+static NullGlShader* null_gl_find_shader( GLuint id )
+{
+    for ( NullGlShader& shader : null_gl_shaders )
+    {
+        if ( shader.id == id )
+        {
+            return &shader;
+        }
+    }
+    return nullptr;
+}
+
+static NullGlProgram* null_gl_find_program( GLuint id )
+{
+    for ( NullGlProgram& program : null_gl_programs )
+    {
+        if ( program.id == id )
+        {
+            return &program;
+        }
+    }
+    return nullptr;
+}
+
+static void null_gl_add_uniform( char ( *uniforms )[ MAX_NULL_GL_UNIFORM_NAME ], int* number_of_uniforms, const char* name, size_t length )
+{
+    length = std::min( length, ( size_t )( MAX_NULL_GL_UNIFORM_NAME - 1 ) );
+    for ( int i = 0; i < *number_of_uniforms; ++i )
+    {
+        if ( strncmp( uniforms[ i ], name, length ) == 0 && uniforms[ i ][ length ] == '\0' )
+        {
+            return;
+        }
+    }
+    if ( *number_of_uniforms == MAX_NULL_GL_UNIFORMS )
+    {
+        return;
+    }
+    memcpy( uniforms[ *number_of_uniforms ], name, length );
+    uniforms[ *number_of_uniforms ][ length ] = '\0';
+    ++*number_of_uniforms;
+}
+
+// Finds “uniform <type> <name>” declarations. Ones inside #ifdefs count whether or not they’re compiled in,
+// which only means a few more uniforms are reported than a driver would.
+static void null_gl_scan_uniforms( NullGlShader& shader, const char* source, size_t length )
+{
+    const char* end = source + length;
+    for ( const char* c = source; c + 8 < end; ++c )
+    {
+        const bool line_start = c == source || c[ -1 ] == '\n' || c[ -1 ] == ' ';
+        if ( !line_start || strncmp( c, "uniform ", 8 ) != 0 )
+        {
+            continue;
+        }
+        const char* type = c + 8;
+        const char* name = type;
+        while ( name < end && !isspace( ( unsigned char )( *name ) ) )
+        {
+            ++name;
+        }
+        while ( name < end && isspace( ( unsigned char )( *name ) ) )
+        {
+            ++name;
+        }
+        const char* name_end = name;
+        while ( name_end < end && ( isalnum( ( unsigned char )( *name_end ) ) || *name_end == '_' ) )
+        {
+            ++name_end;
+        }
+        if ( name_end > name )
+        {
+            null_gl_add_uniform( shader.uniforms, &shader.number_of_uniforms, name, name_end - name );
+        }
+        c = name_end - 1;
+    }
+}
+
+static void APIENTRY null_gl_active_texture( GLenum texture )
+{
+    null_gl_record( NULL_GL_ACTIVE_TEXTURE, texture );
+}
+
+static void APIENTRY null_gl_attach_shader( GLuint program, GLuint shader )
+{
+    null_gl_record( NULL_GL_ATTACH_SHADER, program );
+    NullGlProgram* data = null_gl_find_program( program );
+    if ( data && data->number_of_shaders < 2 )
+    {
+        data->shaders[ data->number_of_shaders++ ] = shader;
+    }
+}
+
+static void APIENTRY null_gl_bind_buffer( GLenum target, GLuint buffer )
+{
+    null_gl_record( NULL_GL_BIND_BUFFER, buffer );
+}
+
+static void APIENTRY null_gl_bind_framebuffer( GLenum target, GLuint framebuffer )
+{
+    null_gl_record( NULL_GL_BIND_FRAMEBUFFER, framebuffer );
+}
+
+static void APIENTRY null_gl_bind_texture( GLenum target, GLuint texture )
+{
+    null_gl_record( NULL_GL_BIND_TEXTURE, texture );
+}
+
+static void APIENTRY null_gl_bind_vertex_array( GLuint array )
+{
+    null_gl_record( NULL_GL_BIND_VERTEX_ARRAY, array );
+}
+
+static void APIENTRY null_gl_blend_func( GLenum source, GLenum destination )
+{
+    null_gl_record( NULL_GL_BLEND_FUNC, source );
+}
+
+static void APIENTRY null_gl_buffer_data( GLenum target, GLsizeiptr size, const void* data, GLenum usage )
+{
+    null_gl_record( NULL_GL_BUFFER_DATA, ( unsigned int )( size ) );
+    if ( data )
+    {
+        null_gl_stats.buffer_bytes += size;
+    }
+}
+
+static void APIENTRY null_gl_buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void* data )
+{
+    null_gl_record( NULL_GL_BUFFER_SUB_DATA, ( unsigned int )( size ) );
+    null_gl_stats.buffer_bytes += size;
+}
+
+static GLenum APIENTRY null_gl_check_framebuffer_status( GLenum target )
+{
+    null_gl_record( NULL_GL_CHECK_FRAMEBUFFER_STATUS, target );
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void APIENTRY null_gl_clear( GLbitfield mask )
+{
+    null_gl_record( NULL_GL_CLEAR, mask );
+}
+
+static void APIENTRY null_gl_clear_color( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha )
+{
+    null_gl_record( NULL_GL_CLEAR_COLOR, 0 );
+}
+
+static void APIENTRY null_gl_compile_shader( GLuint shader )
+{
+    null_gl_record( NULL_GL_COMPILE_SHADER, shader );
+}
+
+static GLuint APIENTRY null_gl_create_program()
+{
+    const GLuint id = null_gl_next_id++;
+    null_gl_record( NULL_GL_CREATE_PROGRAM, id );
+    NullGlProgram* program = null_gl_find_program( 0 );
+    if ( program )
+    {
+        memset( program, 0, sizeof( *program ) );
+        program->id = id;
+    }
+    return id;
+}
+
+static GLuint APIENTRY null_gl_create_shader( GLenum type )
+{
+    const GLuint id = null_gl_next_id++;
+    null_gl_record( NULL_GL_CREATE_SHADER, id );
+    NullGlShader* shader = null_gl_find_shader( 0 );
+    if ( shader )
+    {
+        memset( shader, 0, sizeof( *shader ) );
+        shader->id = id;
+    }
+    return id;
+}
+
+static void APIENTRY null_gl_delete_program( GLuint program )
+{
+    null_gl_record( NULL_GL_DELETE_PROGRAM, program );
+    NullGlProgram* data = null_gl_find_program( program );
+    if ( data && program != 0 )
+    {
+        data->id = 0;
+    }
+}
+
+static void APIENTRY null_gl_delete_shader( GLuint shader )
+{
+    null_gl_record( NULL_GL_DELETE_SHADER, shader );
+    NullGlShader* data = null_gl_find_shader( shader );
+    if ( data && shader != 0 )
+    {
+        data->id = 0;
+    }
+}
+
+static void APIENTRY null_gl_disable( GLenum capability )
+{
+    null_gl_record( NULL_GL_DISABLE, capability );
+}
+
+static void APIENTRY null_gl_draw_elements( GLenum mode, GLsizei count, GLenum type, const void* indices )
+{
+    null_gl_record( NULL_GL_DRAW_ELEMENTS, ( unsigned int )( count ) );
+    ++null_gl_stats.draw_calls;
+}
+
+static void APIENTRY null_gl_enable( GLenum capability )
+{
+    null_gl_record( NULL_GL_ENABLE, capability );
+}
+
+static void APIENTRY null_gl_enable_vertex_attrib_array( GLuint index )
+{
+    null_gl_record( NULL_GL_ENABLE_VERTEX_ATTRIB_ARRAY, index );
+}
+
+static void APIENTRY null_gl_framebuffer_texture_2d( GLenum target, GLenum attachment, GLenum texture_target, GLuint texture, GLint level )
+{
+    null_gl_record( NULL_GL_FRAMEBUFFER_TEXTURE_2D, texture );
+}
+
+static void APIENTRY null_gl_gen_buffers( GLsizei count, GLuint* buffers )
+{
+    null_gl_generate( NULL_GL_GEN_BUFFERS, count, buffers );
+}
+
+static void APIENTRY null_gl_gen_framebuffers( GLsizei count, GLuint* framebuffers )
+{
+    null_gl_generate( NULL_GL_GEN_FRAMEBUFFERS, count, framebuffers );
+}
+
+static void APIENTRY null_gl_gen_queries( GLsizei count, GLuint* queries )
+{
+    null_gl_generate( NULL_GL_GEN_QUERIES, count, queries );
+}
+
+static void APIENTRY null_gl_gen_textures( GLsizei count, GLuint* textures )
+{
+    null_gl_generate( NULL_GL_GEN_TEXTURES, count, textures );
+}
+
+static void APIENTRY null_gl_gen_vertex_arrays( GLsizei count, GLuint* arrays )
+{
+    null_gl_generate( NULL_GL_GEN_VERTEX_ARRAYS, count, arrays );
+}
+
+static void APIENTRY null_gl_get_active_uniform( GLuint program, GLuint index, GLsizei buffer_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name )
+{
+    null_gl_record( NULL_GL_GET_ACTIVE_UNIFORM, program );
+    const NullGlProgram* data = null_gl_find_program( program );
+    const char* uniform = ( data && ( int )( index ) < data->number_of_uniforms ) ? data->uniforms[ index ] : "";
+    const GLsizei copied = std::min( ( GLsizei )( strlen( uniform ) ), buffer_size - 1 );
+    memcpy( name, uniform, copied );
+    name[ copied ] = '\0';
+    if ( length )
+    {
+        *length = copied;
+    }
+    *size = 1;
+    *type = GL_FLOAT;
+}
+
+static GLenum APIENTRY null_gl_get_error()
+{
+    null_gl_record( NULL_GL_GET_ERROR, 0 );
+    return GL_NO_ERROR;
+}
+
+// glad won’t load a context with no extensions at all, so there’s one that means nothing.
+static void APIENTRY null_gl_get_integerv( GLenum name, GLint* data )
+{
+    null_gl_record( NULL_GL_GET_INTEGERV, name );
+    *data = ( name == GL_NUM_EXTENSIONS ) ? 1 : 0;
+}
+
+static void APIENTRY null_gl_get_program_info_log( GLuint program, GLsizei buffer_size, GLsizei* length, GLchar* log )
+{
+    null_gl_record( NULL_GL_GET_PROGRAM_INFO_LOG, program );
+    if ( length )
+    {
+        *length = 0;
+    }
+    if ( buffer_size > 0 )
+    {
+        log[ 0 ] = '\0';
+    }
+}
+
+// Programs link the moment they’re asked to, & every uniform in their shaders’ source is active.
+static void APIENTRY null_gl_get_programiv( GLuint program, GLenum name, GLint* parameter )
+{
+    null_gl_record( NULL_GL_GET_PROGRAMIV, program );
+    const NullGlProgram* data = null_gl_find_program( program );
+    switch ( name )
+    {
+        case GL_LINK_STATUS:
+        case GL_COMPLETION_STATUS_KHR: *parameter = GL_TRUE; break;
+        case GL_ACTIVE_UNIFORMS: *parameter = ( data ) ? data->number_of_uniforms : 0; break;
+        default: *parameter = 0; break;
+    }
+}
+
+static void APIENTRY null_gl_get_query_objectiv( GLuint query, GLenum name, GLint* parameter )
+{
+    null_gl_record( NULL_GL_GET_QUERY_OBJECTIV, query );
+    *parameter = ( name == GL_QUERY_RESULT_AVAILABLE ) ? GL_TRUE : 0;
+}
+
+static void APIENTRY null_gl_get_query_objectui64v( GLuint query, GLenum name, GLuint64* parameter )
+{
+    null_gl_record( NULL_GL_GET_QUERY_OBJECTUI64V, query );
+    *parameter = 0;
+}
+
+static void APIENTRY null_gl_get_shader_info_log( GLuint shader, GLsizei buffer_size, GLsizei* length, GLchar* log )
+{
+    null_gl_record( NULL_GL_GET_SHADER_INFO_LOG, shader );
+    if ( length )
+    {
+        *length = 0;
+    }
+    if ( buffer_size > 0 )
+    {
+        log[ 0 ] = '\0';
+    }
+}
+
+static void APIENTRY null_gl_get_shaderiv( GLuint shader, GLenum name, GLint* parameter )
+{
+    null_gl_record( NULL_GL_GET_SHADERIV, shader );
+    *parameter = ( name == GL_COMPILE_STATUS ) ? GL_TRUE : 0;
+}
+
+static const GLubyte* APIENTRY null_gl_get_string( GLenum name )
+{
+    null_gl_record( NULL_GL_GET_STRING, name );
+    switch ( name )
+    {
+        case GL_VERSION: return ( const GLubyte* )( "3.3.0 Null GL" );
+        case GL_SHADING_LANGUAGE_VERSION: return ( const GLubyte* )( "3.30 Null GL" );
+        default: return ( const GLubyte* )( "Null GL" );
+    }
+}
+
+static const GLubyte* APIENTRY null_gl_get_stringi( GLenum name, GLuint index )
+{
+    null_gl_record( NULL_GL_GET_STRINGI, index );
+    return ( const GLubyte* )( "GL_NULL_gl" );
+}
+
+static GLint APIENTRY null_gl_get_uniform_location( GLuint program, const GLchar* name )
+{
+    null_gl_record( NULL_GL_GET_UNIFORM_LOCATION, program );
+    const NullGlProgram* data = null_gl_find_program( program );
+    for ( int i = 0; data && i < data->number_of_uniforms; ++i )
+    {
+        if ( strcmp( data->uniforms[ i ], name ) == 0 )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void APIENTRY null_gl_link_program( GLuint program )
+{
+    null_gl_record( NULL_GL_LINK_PROGRAM, program );
+    NullGlProgram* data = null_gl_find_program( program );
+    if ( !data )
+    {
+        return;
+    }
+    for ( int i = 0; i < data->number_of_shaders; ++i )
+    {
+        const NullGlShader* shader = null_gl_find_shader( data->shaders[ i ] );
+        for ( int uniform = 0; shader && uniform < shader->number_of_uniforms; ++uniform )
+        {
+            null_gl_add_uniform( data->uniforms, &data->number_of_uniforms, shader->uniforms[ uniform ], strlen( shader->uniforms[ uniform ] ) );
+        }
+    }
+}
+
+static void APIENTRY null_gl_pixel_storei( GLenum name, GLint parameter )
+{
+    null_gl_record( NULL_GL_PIXEL_STOREI, name );
+}
+
+static void APIENTRY null_gl_query_counter( GLuint query, GLenum target )
+{
+    null_gl_record( NULL_GL_QUERY_COUNTER, query );
+}
+
+static void APIENTRY null_gl_shader_source( GLuint shader, GLsizei count, const GLchar* const* source, const GLint* length )
+{
+    null_gl_record( NULL_GL_SHADER_SOURCE, shader );
+    NullGlShader* data = null_gl_find_shader( shader );
+    for ( GLsizei i = 0; data && i < count; ++i )
+    {
+        null_gl_scan_uniforms( *data, source[ i ], ( length && length[ i ] >= 0 ) ? ( size_t )( length[ i ] ) : strlen( source[ i ] ) );
+    }
+}
+
+static void APIENTRY null_gl_tex_image_2d( GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels )
+{
+    null_gl_record( NULL_GL_TEX_IMAGE_2D, ( unsigned int )( width * height ) );
+    if ( pixels )
+    {
+        null_gl_stats.texture_bytes += ( size_t )( width ) * height * null_gl_get_pixel_size( format, type );
+    }
+}
+
+static void APIENTRY null_gl_tex_parameteri( GLenum target, GLenum name, GLint parameter )
+{
+    null_gl_record( NULL_GL_TEX_PARAMETERI, name );
+}
+
+static void APIENTRY null_gl_tex_sub_image_2d( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels )
+{
+    null_gl_record( NULL_GL_TEX_SUB_IMAGE_2D, ( unsigned int )( width * height ) );
+    null_gl_stats.texture_bytes += ( size_t )( width ) * height * null_gl_get_pixel_size( format, type );
+}
+
+static void APIENTRY null_gl_uniform_1f( GLint location, GLfloat value )
+{
+    null_gl_record( NULL_GL_UNIFORM_1F, ( unsigned int )( location ) );
+}
+
+static void APIENTRY null_gl_uniform_1i( GLint location, GLint value )
+{
+    null_gl_record( NULL_GL_UNIFORM_1I, ( unsigned int )( location ) );
+}
+
+static void APIENTRY null_gl_uniform_4fv( GLint location, GLsizei count, const GLfloat* value )
+{
+    null_gl_record( NULL_GL_UNIFORM_4FV, ( unsigned int )( location ) );
+}
+
+static void APIENTRY null_gl_uniform_matrix_4fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value )
+{
+    null_gl_record( NULL_GL_UNIFORM_MATRIX_4FV, ( unsigned int )( location ) );
+}
+
+static void APIENTRY null_gl_use_program( GLuint program )
+{
+    null_gl_record( NULL_GL_USE_PROGRAM, program );
+}
+
+static void APIENTRY null_gl_vertex_attrib_i_pointer( GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer )
+{
+    null_gl_record( NULL_GL_VERTEX_ATTRIB_I_POINTER, index );
+}
+
+static void APIENTRY null_gl_vertex_attrib_pointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer )
+{
+    null_gl_record( NULL_GL_VERTEX_ATTRIB_POINTER, index );
+}
+
+static void APIENTRY null_gl_viewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    null_gl_record( NULL_GL_VIEWPORT, 0 );
+}
+
+static void APIENTRY null_gl_ignored()
+{
+    null_gl_record( NULL_GL_OTHER, 0 );
+}
+
+
+
+//
+//  GLFW
+//
+///////////////////////////////////////////////////////////
+
+// Null GL builds don’t link GLFW; these stand in for the calls the engine makes.
+int glfwInit()
+{
+    return GLFW_TRUE;
+}
+
+void glfwTerminate()
+{
+}
+
+void glfwWindowHint( int hint, int value )
+{
+}
+
+GLFWwindow* glfwCreateWindow( int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share )
+{
+    return ( GLFWwindow* )( &null_window );
+}
+
+void glfwMakeContextCurrent( GLFWwindow* window )
+{
+}
+
+GLFWwindow* glfwGetCurrentContext()
+{
+    return ( GLFWwindow* )( &null_window );
+}
+
+int glfwWindowShouldClose( GLFWwindow* window )
+{
+    return null_gl_stats.frames >= CONFIG_NULL_GL_FRAMES;
+}
+
+void glfwSwapBuffers( GLFWwindow* window )
+{
+    ++null_gl_stats.frames;
+}
+
+void glfwPollEvents()
+{
+}
+
+int glfwGetKey( GLFWwindow* window, int key )
+{
+    return GLFW_RELEASE;
+}
+
+void glfwGetFramebufferSize( GLFWwindow* window, int* width, int* height )
+{
+    *width = CONFIG_WINDOW_WIDTH_PIXELS;
+    *height = CONFIG_WINDOW_HEIGHT_PIXELS;
+}
+
+double glfwGetTime()
+{
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - null_start_time ).count();
+}
+
+int glfwExtensionSupported( const char* extension )
+{
+    return GLFW_FALSE;
+}
+
+GLFWglproc glfwGetProcAddress( const char* name )
+{
+    return ( GLFWglproc )( null_gl_get_proc_address( name ) );
+}
+
+#endif
@@ -1,8 +1,88 @@
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include "glad.h"
 #include "glfw3.h"
 #include "ogl_error.hpp"
 
+// KHR_debug is core from GL 4.3, past what our 3.3 loader covers.
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+
+#define OGL_DEBUG_RING_SIZE 64
+#define OGL_DEBUG_MESSAGE_SIZE 256
+#define OGL_DEBUG_SEEN_SIZE 256
+
+static_assert( ( OGL_DEBUG_RING_SIZE & ( OGL_DEBUG_RING_SIZE - 1 ) ) == 0, "Debug message ring size must be a power o’ 2." );
+static_assert( ( OGL_DEBUG_SEEN_SIZE & ( OGL_DEBUG_SEEN_SIZE - 1 ) ) == 0, "Debug message table size must be a power o’ 2." );
+
+typedef void ( APIENTRYP OglDebugMessageCallbackFunction )( GLDEBUGPROC callback, const void* user_parameter );
+
+// A slot is free for the producer whose position equals sequence, & ready for the consumer once sequence is 1 past that.
+struct OglDebugMessage
+{
+    std::atomic<uint32_t> sequence;
+    GLenum severity;
+    GLuint id;
+    char text[ OGL_DEBUG_MESSAGE_SIZE ];
+};
+
+// Messages already queued once, keyed by a hash o’ their id & text. Drivers tend to repeat the same warning every
+// frame, so repeats are only counted.
+struct OglDebugSeen
+{
+    std::atomic<uint64_t> key;
+    std::atomic<uint32_t> repeats;
+    uint32_t reported_repeats;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+#if CONFIG_OGL_ERROR_LEVEL != OGL_ERRORS_OFF
+static void APIENTRY ogl_debug_callback( GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_parameter );
+static bool ogl_mark_seen( GLuint id, const GLchar* message );
+static const char* ogl_get_severity_text( GLenum severity );
+#endif
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+#if CONFIG_OGL_ERROR_LEVEL != OGL_ERRORS_OFF
+static OglDebugMessage debug_ring[ OGL_DEBUG_RING_SIZE ];
+static std::atomic<uint32_t> debug_ring_head( 0 );
+static uint32_t debug_ring_tail = 0;
+static std::atomic<uint32_t> debug_messages_dropped( 0 );
+static uint32_t debug_messages_dropped_reported = 0;
+static OglDebugSeen debug_seen[ OGL_DEBUG_SEEN_SIZE ];
+#endif
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
 void ogl_clear_error()
 {
     while( glGetError() != GL_NO_ERROR );
@@ -23,4 +103,152 @@ void ogl_check_error()
     {
         printf( "OpenGL Error: %d\n", error );
     }
-}
\ No newline at end of file
+}
+
+void ogl_init_debug_output()
+{
+#if CONFIG_OGL_ERROR_LEVEL != OGL_ERRORS_OFF
+    if ( !glfwExtensionSupported( "GL_KHR_debug" ) )
+    {
+        return;
+    }
+    OglDebugMessageCallbackFunction debug_message_callback = ( OglDebugMessageCallbackFunction )( glfwGetProcAddress( "glDebugMessageCallback" ) );
+    if ( !debug_message_callback )
+    {
+        return;
+    }
+
+    for ( uint32_t i = 0; i < OGL_DEBUG_RING_SIZE; ++i )
+    {
+        debug_ring[ i ].sequence.store( i, std::memory_order_relaxed );
+    }
+    debug_message_callback( ogl_debug_callback, nullptr );
+    glEnable( GL_DEBUG_OUTPUT );
+    if ( CONFIG_OGL_ERROR_LEVEL == OGL_ERRORS_SYNCHRONOUS )
+    {
+        glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS );
+    }
+#endif
+}
+
+void ogl_flush_debug_messages()
+{
+#if CONFIG_OGL_ERROR_LEVEL != OGL_ERRORS_OFF
+    for ( ;; )
+    {
+        OglDebugMessage& slot = debug_ring[ debug_ring_tail & ( OGL_DEBUG_RING_SIZE - 1 ) ];
+        if ( slot.sequence.load( std::memory_order_acquire ) != debug_ring_tail + 1 )
+        {
+            break;
+        }
+        printf( "OpenGL %s %u: %s\n", ogl_get_severity_text( slot.severity ), slot.id, slot.text );
+        slot.sequence.store( debug_ring_tail + OGL_DEBUG_RING_SIZE, std::memory_order_release );
+        ++debug_ring_tail;
+    }
+
+    // Repeats are reported each time their count doubles, so a message repeated every frame doesn’t flood the log.
+    for ( OglDebugSeen& seen : debug_seen )
+    {
+        const uint32_t repeats = seen.repeats.load( std::memory_order_relaxed );
+        if ( repeats >= seen.reported_repeats * 2 && repeats > 0 )
+        {
+            const uint64_t key = seen.key.load( std::memory_order_relaxed );
+            printf( "OpenGL message %u (%08x) repeated %u times so far.\n", ( uint32_t )( key ), ( uint32_t )( key >> 32 ), repeats );
+            seen.reported_repeats = repeats;
+        }
+    }
+
+    const uint32_t dropped = debug_messages_dropped.load( std::memory_order_relaxed );
+    if ( dropped != debug_messages_dropped_reported )
+    {
+        printf( "%u OpenGL messages dropped; the queue was full.\n", dropped - debug_messages_dropped_reported );
+        debug_messages_dropped_reported = dropped;
+    }
+#endif
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+#if CONFIG_OGL_ERROR_LEVEL != OGL_ERRORS_OFF
+// May run on a driver thread, several at once, so it only copies the message into the ring & ne’er blocks.
+static void APIENTRY ogl_debug_callback( GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_parameter )
+{
+    if ( severity == GL_DEBUG_SEVERITY_NOTIFICATION || !ogl_mark_seen( id, message ) )
+    {
+        return;
+    }
+
+    uint32_t position = debug_ring_head.load( std::memory_order_relaxed );
+    OglDebugMessage* slot;
+    for ( ;; )
+    {
+        slot = &debug_ring[ position & ( OGL_DEBUG_RING_SIZE - 1 ) ];
+        const int32_t difference = ( int32_t )( slot->sequence.load( std::memory_order_acquire ) - position );
+        if ( difference == 0 )
+        {
+            if ( debug_ring_head.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+            {
+                break;
+            }
+        }
+        else if ( difference < 0 )
+        {
+            debug_messages_dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+        else
+        {
+            position = debug_ring_head.load( std::memory_order_relaxed );
+        }
+    }
+
+    slot->severity = severity;
+    slot->id = id;
+    strncpy( slot->text, message, OGL_DEBUG_MESSAGE_SIZE - 1 );
+    slot->text[ OGL_DEBUG_MESSAGE_SIZE - 1 ] = '\0';
+    slot->sequence.store( position + 1, std::memory_order_release );
+}
+
+// Returns true the first time a message is seen. The low 32 bits o’ each key are the message id, for reporting repeats.
+static bool ogl_mark_seen( GLuint id, const GLchar* message )
+{
+    uint32_t hash = 0x811C9DC5u;
+    for ( const unsigned char* c = ( const unsigned char* )( message ); *c != '\0'; ++c )
+    {
+        hash = ( hash ^ *c ) * 0x01000193u;
+    }
+    const uint64_t key = ( ( uint64_t )( hash | 1u ) << 32 ) | id;
+
+    for ( uint32_t probe = 0; probe < OGL_DEBUG_SEEN_SIZE; ++probe )
+    {
+        OglDebugSeen& seen = debug_seen[ ( hash + probe ) & ( OGL_DEBUG_SEEN_SIZE - 1 ) ];
+        uint64_t expected = 0;
+        if ( seen.key.compare_exchange_strong( expected, key, std::memory_order_relaxed ) )
+        {
+            return true;
+        }
+        if ( expected == key )
+        {
+            seen.repeats.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+    }
+    return true; // Table’s full; better to repeat a message than lose one.
+}
+
+static const char* ogl_get_severity_text( GLenum severity )
+{
+    switch ( severity )
+    {
+        case GL_DEBUG_SEVERITY_HIGH: return "error";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "warning";
+        case GL_DEBUG_SEVERITY_LOW: return "note";
+        default: return "message";
+    }
+}
+#endif
@@ -0,0 +1,553 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include "glad.h"
+#include "palette.hpp"
+#include "profiler.hpp"
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_PALETTE_ANIMATIONS 32
+#define MAX_FILENAME 255
+#define PALETTE_FILE_HEADER_SIZE 6
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_CHUNK_HEADER_SIZE 8
+#define PNG_CHUNK_CRC_SIZE 4
+
+static_assert( PALETTE_ROWS <= 64, "Dirty palette rows are tracked in a 64-bit mask." );
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void palette_mark_dirty( int row, int first, int count );
+static void palette_step_animation( int animation );
+static void palette_lerp( unsigned char* dest, const unsigned char* a, const unsigned char* b, int amount, bool lerp_alpha );
+static const unsigned char* palette_map_file( const char* filename, size_t* file_size );
+static void palette_upload_rows( int first_row, int count );
+static int read_u16( const unsigned char* data );
+static uint32_t read_u32( const unsigned char* data );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+// Palettes are rows o’ one 256 x PALETTE_ROWS texture bound to texture unit 0, mirrored here as RGBA8.
+static unsigned int palette_texture;
+static unsigned char palette_colors[ PALETTE_ROWS ][ PALETTE_ROW_SIZE ] = {};
+
+// Only the changed span o’ each changed row goes up to the GPU at the start o’ the next frame.
+static uint64_t dirty_rows = 0;
+static int dirty_first[ PALETTE_ROWS ];
+static int dirty_last[ PALETTE_ROWS ];
+static size_t palette_bytes_uploaded = 0;
+
+enum class PaletteAnimationType
+{
+    NONE,
+    CYCLE,
+    CYCLE_BACKWARD,
+    KEYFRAMES
+};
+
+struct PaletteAnimation
+{
+    PaletteAnimationType type;
+    int row;
+    int first;
+    int count;
+    int frames_per_step;
+    int frame;
+    int keyframe;
+    int number_of_keyframes;
+    unsigned char* keyframes;
+};
+
+static PaletteAnimation animations[ MAX_PALETTE_ANIMATIONS ] = {};
+
+// Loaded palettes fill rows in order & can be looked up by name; rows past these are free for effects to write into.
+static std::unordered_map<std::string, int> palette_map;
+static int number_of_palette_rows = 0;
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void palette_init()
+{
+    glGenTextures( 1, &palette_texture );
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, palette_texture );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, PALETTE_COLORS, PALETTE_ROWS, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_colors );
+    palette_bytes_uploaded += sizeof( palette_colors );
+}
+
+int palette_load( const char* name )
+{
+    PROFILE_ZONE( "palette_load" );
+    char full_filename[ MAX_FILENAME + 9 ] = "bin/";
+    strcat( full_filename, name );
+    strcat( full_filename, ".jwp" );
+
+    size_t file_size;
+    const unsigned char* file_data = palette_map_file( full_filename, &file_size );
+    if ( !file_data )
+    {
+        return -1;
+    }
+
+    if ( file_size < PALETTE_FILE_HEADER_SIZE || memcmp( file_data, "JWP\x01", 4 ) != 0 )
+    {
+        printf( "Palette Load Error: %s isn’t a valid palette file.\n", full_filename );
+        munmap( ( void* )( file_data ), file_size );
+        return -1;
+    }
+
+    const int number_of_palettes = read_u16( &file_data[ 4 ] );
+    if ( number_of_palette_rows + number_of_palettes > PALETTE_ROWS )
+    {
+        printf( "Not ’nough room for %s’s %d palettes.\n", name, number_of_palettes );
+        munmap( ( void* )( file_data ), file_size );
+        return -1;
+    }
+
+    // Fill the mirror’s rows straight from the mapping, then send them all up in one go.
+    const int first_row = number_of_palette_rows;
+    const unsigned char* data = &file_data[ PALETTE_FILE_HEADER_SIZE ];
+    const unsigned char* const file_end = file_data + file_size;
+    for ( int palette = 0; palette < number_of_palettes; ++palette )
+    {
+        if ( data + 3 > file_end || data + 3 + data[ 0 ] > file_end )
+        {
+            printf( "Palette Load Error: %s is truncated.\n", full_filename );
+            break;
+        }
+        const int name_length = data[ 0 ];
+        const int number_of_colors = read_u16( &data[ 1 + name_length ] );
+        const size_t colors_size = ( size_t )( number_of_colors * CHANNELS_PER_COLOR );
+        if ( data + 3 + name_length + colors_size > file_end || number_of_colors > PALETTE_COLORS )
+        {
+            printf( "Palette Load Error: %s is truncated.\n", full_filename );
+            break;
+        }
+
+        const int row = number_of_palette_rows++;
+        memcpy( palette_colors[ row ], &data[ 3 + name_length ], colors_size );
+        memset( &palette_colors[ row ][ colors_size ], 0, PALETTE_ROW_SIZE - colors_size );
+        palette_map[ std::string( ( const char* )( &data[ 1 ] ), name_length ) ] = row;
+        data += 3 + name_length + colors_size;
+    }
+    palette_upload_rows( first_row, number_of_palette_rows - first_row );
+
+    munmap( ( void* )( file_data ), file_size );
+    return first_row;
+}
+
+int palette_load_png( const char* name, const char* filename )
+{
+    PROFILE_ZONE( "palette_load_png" );
+    if ( number_of_palette_rows == PALETTE_ROWS )
+    {
+        printf( "Not ’nough room for any mo’ palettes.\n" );
+        return -1;
+    }
+
+    size_t file_size;
+    const unsigned char* file_data = palette_map_file( filename, &file_size );
+    if ( !file_data )
+    {
+        return -1;
+    }
+
+    if ( file_size < PNG_SIGNATURE_SIZE || memcmp( file_data, "\x89PNG\r\n\x1a\n", PNG_SIGNATURE_SIZE ) != 0 )
+    {
+        printf( "Palette Load Error: %s isn’t a PNG.\n", filename );
+        munmap( ( void* )( file_data ), file_size );
+        return -1;
+    }
+
+    // PLTE holds RGB triples; tRNS, if there, holds alpha for the first however-many o’ them.
+    unsigned char colors[ PALETTE_ROW_SIZE ] = {};
+    int number_of_colors = 0;
+    const unsigned char* chunk = &file_data[ PNG_SIGNATURE_SIZE ];
+    const unsigned char* const file_end = file_data + file_size;
+    while ( chunk + PNG_CHUNK_HEADER_SIZE <= file_end )
+    {
+        const size_t chunk_size = read_u32( chunk );
+        const unsigned char* chunk_data = chunk + PNG_CHUNK_HEADER_SIZE;
+        if ( chunk_size > ( size_t )( file_end - chunk_data ) || memcmp( &chunk[ 4 ], "IDAT", 4 ) == 0 || memcmp( &chunk[ 4 ], "IEND", 4 ) == 0 )
+        {
+            break;
+        }
+
+        if ( memcmp( &chunk[ 4 ], "PLTE", 4 ) == 0 )
+        {
+            number_of_colors = ( int )( chunk_size / 3 );
+            number_of_colors = ( number_of_colors > PALETTE_COLORS ) ? PALETTE_COLORS : number_of_colors;
+            for ( int color = 0; color < number_of_colors; ++color )
+            {
+                memcpy( &colors[ color * CHANNELS_PER_COLOR ], &chunk_data[ color * 3 ], 3 );
+                colors[ color * CHANNELS_PER_COLOR + 3 ] = 255;
+            }
+        }
+        else if ( memcmp( &chunk[ 4 ], "tRNS", 4 ) == 0 )
+        {
+            for ( int color = 0; color < ( int )( chunk_size ) && color < number_of_colors; ++color )
+            {
+                colors[ color * CHANNELS_PER_COLOR + 3 ] = chunk_data[ color ];
+            }
+        }
+        chunk = chunk_data + chunk_size + PNG_CHUNK_CRC_SIZE;
+    }
+    munmap( ( void* )( file_data ), file_size );
+
+    if ( number_of_colors == 0 )
+    {
+        printf( "Palette Load Error: %s has no palette. Must be indexed PNG.\n", filename );
+        return -1;
+    }
+    return palette_add_row( name, colors );
+}
+
+int palette_add_row( const char* name, const unsigned char* colors )
+{
+    if ( number_of_palette_rows == PALETTE_ROWS )
+    {
+        printf( "Not ’nough room for any mo’ palettes.\n" );
+        return -1;
+    }
+
+    const int row = number_of_palette_rows++;
+    palette_map[ name ] = row;
+    if ( colors )
+    {
+        palette_set_row( row, colors );
+    }
+    return row;
+}
+
+int palette_get_row( const char* name )
+{
+    const auto palette = palette_map.find( name );
+    return ( palette != palette_map.end() ) ? palette->second : -1;
+}
+
+void palette_set_row( int row, const unsigned char* colors )
+{
+    palette_set_colors( row, 0, PALETTE_COLORS, colors );
+}
+
+void palette_set_colors( int row, int first, int count, const unsigned char* colors )
+{
+    memcpy( &palette_colors[ row ][ first * CHANNELS_PER_COLOR ], colors, count * CHANNELS_PER_COLOR );
+    palette_mark_dirty( row, first, count );
+}
+
+const unsigned char* palette_get_color( int row, int index )
+{
+    return &palette_colors[ row ][ index * CHANNELS_PER_COLOR ];
+}
+
+void palette_upload_dirty_rows()
+{
+    if ( dirty_rows == 0 )
+    {
+        return;
+    }
+
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, palette_texture );
+    for ( int row = 0; row < PALETTE_ROWS; ++row )
+    {
+        if ( dirty_rows & ( ( uint64_t )( 1 ) << row ) )
+        {
+            const int count = dirty_last[ row ] - dirty_first[ row ] + 1;
+            glTexSubImage2D( GL_TEXTURE_2D, 0, dirty_first[ row ], row, count, 1, GL_RGBA, GL_UNSIGNED_BYTE, palette_get_color( row, dirty_first[ row ] ) );
+            palette_bytes_uploaded += count * CHANNELS_PER_COLOR;
+        }
+    }
+    dirty_rows = 0;
+}
+
+size_t palette_get_bytes_uploaded()
+{
+    return palette_bytes_uploaded;
+}
+
+int palette_add_cycle( int row, int first, int count, int frames_per_step, bool backward )
+{
+    for ( int animation = 0; animation < MAX_PALETTE_ANIMATIONS; ++animation )
+    {
+        if ( animations[ animation ].type == PaletteAnimationType::NONE )
+        {
+            animations[ animation ] =
+            {
+                ( backward ) ? PaletteAnimationType::CYCLE_BACKWARD : PaletteAnimationType::CYCLE,
+                row,
+                first,
+                count,
+                frames_per_step,
+                0,
+                0,
+                0,
+                nullptr
+            };
+            return animation;
+        }
+    }
+    printf( "Not ’nough room for any mo’ palette animations.\n" );
+    return -1;
+}
+
+int palette_add_keyframes( int row, int first, int count, const unsigned char* keyframes, int number_of_keyframes, int frames_per_keyframe )
+{
+    for ( int animation = 0; animation < MAX_PALETTE_ANIMATIONS; ++animation )
+    {
+        if ( animations[ animation ].type == PaletteAnimationType::NONE )
+        {
+            const size_t keyframes_size = ( size_t )( count * CHANNELS_PER_COLOR * number_of_keyframes );
+            unsigned char* keyframes_copy = ( unsigned char* )( malloc( keyframes_size ) );
+            memcpy( keyframes_copy, keyframes, keyframes_size );
+            animations[ animation ] =
+            {
+                PaletteAnimationType::KEYFRAMES,
+                row,
+                first,
+                count,
+                frames_per_keyframe,
+                0,
+                0,
+                number_of_keyframes,
+                keyframes_copy
+            };
+            palette_set_colors( row, first, count, keyframes_copy );
+            return animation;
+        }
+    }
+    printf( "Not ’nough room for any mo’ palette animations.\n" );
+    return -1;
+}
+
+void palette_remove_animation( int animation )
+{
+    free( animations[ animation ].keyframes );
+    animations[ animation ] = {};
+}
+
+void palette_update()
+{
+    for ( int animation = 0; animation < MAX_PALETTE_ANIMATIONS; ++animation )
+    {
+        if ( animations[ animation ].type != PaletteAnimationType::NONE && ++animations[ animation ].frame >= animations[ animation ].frames_per_step )
+        {
+            animations[ animation ].frame = 0;
+            palette_step_animation( animation );
+        }
+    }
+}
+
+void palette_fade( int dest_row, int source_row, const unsigned char* target_color, int amount )
+{
+    alignas( 16 ) unsigned char target_row[ PALETTE_ROW_SIZE ];
+    for ( int color = 0; color < PALETTE_COLORS; ++color )
+    {
+        memcpy( &target_row[ color * CHANNELS_PER_COLOR ], target_color, CHANNELS_PER_COLOR );
+    }
+    palette_lerp( palette_colors[ dest_row ], palette_colors[ source_row ], target_row, amount, false );
+    palette_mark_dirty( dest_row, 0, PALETTE_COLORS );
+}
+
+void palette_blend( int dest_row, int row_a, int row_b, int amount )
+{
+    palette_lerp( palette_colors[ dest_row ], palette_colors[ row_a ], palette_colors[ row_b ], amount, true );
+    palette_mark_dirty( dest_row, 0, PALETTE_COLORS );
+}
+
+void palette_make_fade_lut( PaletteLUT* lut, const unsigned char* target_color, int amount )
+{
+    const int weight = amount + ( amount >> 7 );
+    for ( int value = 0; value < PALETTE_COLORS; ++value )
+    {
+        lut->r[ value ] = ( unsigned char )( ( value * ( 256 - weight ) + target_color[ 0 ] * weight ) >> 8 );
+        lut->g[ value ] = ( unsigned char )( ( value * ( 256 - weight ) + target_color[ 1 ] * weight ) >> 8 );
+        lut->b[ value ] = ( unsigned char )( ( value * ( 256 - weight ) + target_color[ 2 ] * weight ) >> 8 );
+    }
+}
+
+void palette_apply_lut( int dest_row, int source_row, const PaletteLUT* lut )
+{
+    const unsigned char* source = palette_colors[ source_row ];
+    unsigned char* dest = palette_colors[ dest_row ];
+    for ( int color = 0; color < PALETTE_ROW_SIZE; color += CHANNELS_PER_COLOR )
+    {
+        dest[ color ] = lut->r[ source[ color ] ];
+        dest[ color + 1 ] = lut->g[ source[ color + 1 ] ];
+        dest[ color + 2 ] = lut->b[ source[ color + 2 ] ];
+        dest[ color + 3 ] = source[ color + 3 ];
+    }
+    palette_mark_dirty( dest_row, 0, PALETTE_COLORS );
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static void palette_mark_dirty( int row, int first, int count )
+{
+    const uint64_t row_bit = ( uint64_t )( 1 ) << row;
+    const int last = first + count - 1;
+    if ( dirty_rows & row_bit )
+    {
+        dirty_first[ row ] = ( first < dirty_first[ row ] ) ? first : dirty_first[ row ];
+        dirty_last[ row ] = ( last > dirty_last[ row ] ) ? last : dirty_last[ row ];
+    }
+    else
+    {
+        dirty_rows |= row_bit;
+        dirty_first[ row ] = first;
+        dirty_last[ row ] = last;
+    }
+}
+
+static void palette_step_animation( int animation )
+{
+    PaletteAnimation& data = animations[ animation ];
+    unsigned char* colors = &palette_colors[ data.row ][ data.first * CHANNELS_PER_COLOR ];
+    const size_t shifted_size = ( size_t )( ( data.count - 1 ) * CHANNELS_PER_COLOR );
+    unsigned char wrapped[ CHANNELS_PER_COLOR ];
+    switch ( data.type )
+    {
+        case PaletteAnimationType::CYCLE:
+        {
+            memcpy( wrapped, &colors[ shifted_size ], CHANNELS_PER_COLOR );
+            memmove( &colors[ CHANNELS_PER_COLOR ], colors, shifted_size );
+            memcpy( colors, wrapped, CHANNELS_PER_COLOR );
+        }
+        break;
+
+        case PaletteAnimationType::CYCLE_BACKWARD:
+        {
+            memcpy( wrapped, colors, CHANNELS_PER_COLOR );
+            memmove( colors, &colors[ CHANNELS_PER_COLOR ], shifted_size );
+            memcpy( &colors[ shifted_size ], wrapped, CHANNELS_PER_COLOR );
+        }
+        break;
+
+        case PaletteAnimationType::KEYFRAMES:
+        {
+            data.keyframe = ( data.keyframe + 1 ) % data.number_of_keyframes;
+            memcpy( colors, &data.keyframes[ data.keyframe * data.count * CHANNELS_PER_COLOR ], data.count * CHANNELS_PER_COLOR );
+        }
+        break;
+    }
+    palette_mark_dirty( data.row, data.first, data.count );
+}
+
+// dest = a + ( b - a ) * amount / 255 for every channel o’ a whole row, as ( a * ( 256 - w ) + b * w ) >> 8 in 16 bits
+// so 0 & 255 land exactly on a & b. Alpha is left as a’s unless lerp_alpha is set.
+static void palette_lerp( unsigned char* dest, const unsigned char* a, const unsigned char* b, int amount, bool lerp_alpha )
+{
+    const int weight = amount + ( amount >> 7 );
+    const int alpha_weight = ( lerp_alpha ) ? weight : 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i b_weights = _mm_setr_epi16( weight, weight, weight, alpha_weight, weight, weight, weight, alpha_weight );
+    const __m128i a_weights = _mm_sub_epi16( _mm_set1_epi16( 256 ), b_weights );
+    for ( int offset = 0; offset < PALETTE_ROW_SIZE; offset += 16 )
+    {
+        const __m128i a_bytes = _mm_loadu_si128( ( const __m128i* )( &a[ offset ] ) );
+        const __m128i b_bytes = _mm_loadu_si128( ( const __m128i* )( &b[ offset ] ) );
+        const __m128i low = _mm_srli_epi16
+        (
+            _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( a_bytes, zero ), a_weights ), _mm_mullo_epi16( _mm_unpacklo_epi8( b_bytes, zero ), b_weights ) ),
+            8
+        );
+        const __m128i high = _mm_srli_epi16
+        (
+            _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( a_bytes, zero ), a_weights ), _mm_mullo_epi16( _mm_unpackhi_epi8( b_bytes, zero ), b_weights ) ),
+            8
+        );
+        _mm_storeu_si128( ( __m128i* )( &dest[ offset ] ), _mm_packus_epi16( low, high ) );
+    }
+#else
+    for ( int offset = 0; offset < PALETTE_ROW_SIZE; ++offset )
+    {
+        const int channel_weight = ( offset % CHANNELS_PER_COLOR == 3 ) ? alpha_weight : weight;
+        dest[ offset ] = ( unsigned char )( ( a[ offset ] * ( 256 - channel_weight ) + b[ offset ] * channel_weight ) >> 8 );
+    }
+#endif
+}
+
+static const unsigned char* palette_map_file( const char* filename, size_t* file_size )
+{
+    const int file = open( filename, O_RDONLY );
+    if ( file == -1 )
+    {
+        printf( "File didn’t load: %s\n", filename );
+        return nullptr;
+    }
+
+    struct stat file_info;
+    void* data = MAP_FAILED;
+    if ( fstat( file, &file_info ) == 0 && file_info.st_size > 0 )
+    {
+        *file_size = ( size_t )( file_info.st_size );
+        data = mmap( nullptr, *file_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    }
+    close( file );
+
+    if ( data == MAP_FAILED )
+    {
+        printf( "Couldn’t map file %s\n", filename );
+        return nullptr;
+    }
+    return ( const unsigned char* )( data );
+}
+
+// Mirror rows are contiguous, so a run o’ them goes up as one rectangle.
+static void palette_upload_rows( int first_row, int count )
+{
+    if ( count <= 0 )
+    {
+        return;
+    }
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, palette_texture );
+    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, first_row, PALETTE_COLORS, count, GL_RGBA, GL_UNSIGNED_BYTE, palette_colors[ first_row ] );
+    palette_bytes_uploaded += count * PALETTE_ROW_SIZE;
+}
+
+static int read_u16( const unsigned char* data )
+{
+    return ( ( unsigned int )( data[ 0 ] ) << 8 ) | data[ 1 ];
+}
+
+static uint32_t read_u32( const unsigned char* data )
+{
+    return ( ( uint32_t )( data[ 0 ] ) << 24 ) | ( ( uint32_t )( data[ 1 ] ) << 16 ) | ( ( uint32_t )( data[ 2 ] ) << 8 ) | data[ 3 ];
+}
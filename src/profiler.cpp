@@ -0,0 +1,183 @@
+#include "config.hpp"
+#include "profiler.hpp"
+
+#if CONFIG_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#define PROFILE_RING_SIZE 16384
+#define MAX_PROFILE_THREADS 16
+#define MAX_PROFILE_FRAMES 1024
+
+static_assert( ( PROFILE_RING_SIZE & ( PROFILE_RING_SIZE - 1 ) ) == 0, "Profile ring size must be a power o’ 2." );
+static_assert( ( MAX_PROFILE_FRAMES & ( MAX_PROFILE_FRAMES - 1 ) ) == 0, "Profile frame count must be a power o’ 2." );
+
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Each thread only ever writes its own ring, so recording is a plain store & a release o’ head; old events
+// are overwritten once the ring wraps.
+struct ProfileRing
+{
+    ProfileEvent events[ PROFILE_RING_SIZE ];
+    std::atomic<uint64_t> head;
+    int thread_id;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static ProfileRing* profiler_get_thread_ring();
+static void profiler_write_ring( FILE* file, ProfileRing& ring, uint64_t since, bool* first_event );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static ProfileRing profile_rings[ MAX_PROFILE_THREADS ];
+static std::atomic<int> number_of_profile_rings( 0 );
+static thread_local ProfileRing* thread_ring = nullptr;
+
+// Frame start times, written only by the thread that marks frames.
+static uint64_t profile_frames[ MAX_PROFILE_FRAMES ];
+static std::atomic<uint64_t> number_of_profile_frames( 0 );
+
+static const std::chrono::steady_clock::time_point profiler_start_time = std::chrono::steady_clock::now();
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+uint64_t profiler_now()
+{
+    return ( uint64_t )( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - profiler_start_time ).count() );
+}
+
+void profiler_record( const char* name, uint64_t begin, uint64_t end )
+{
+    ProfileRing* ring = profiler_get_thread_ring();
+    if ( !ring )
+    {
+        return;
+    }
+    const uint64_t head = ring->head.load( std::memory_order_relaxed );
+    ring->events[ head & ( PROFILE_RING_SIZE - 1 ) ] = { name, begin, end };
+    ring->head.store( head + 1, std::memory_order_release );
+}
+
+void profiler_mark_frame()
+{
+    const uint64_t frame = number_of_profile_frames.load( std::memory_order_relaxed );
+    profile_frames[ frame & ( MAX_PROFILE_FRAMES - 1 ) ] = profiler_now();
+    number_of_profile_frames.store( frame + 1, std::memory_order_release );
+}
+
+bool profiler_export_chrome_trace( const char* filename, int frames )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( !file )
+    {
+        printf( "Couldn’t write trace file %s\n", filename );
+        return false;
+    }
+
+    // Frames older than the frame table can’t be told apart, so asking for too many just exports everything.
+    const uint64_t frame_count = number_of_profile_frames.load( std::memory_order_acquire );
+    const uint64_t wanted_frames = std::min( ( uint64_t )( std::max( frames, 0 ) ), ( uint64_t )( MAX_PROFILE_FRAMES ) );
+    const uint64_t since = ( frames > 0 && frame_count >= wanted_frames ) ? profile_frames[ ( frame_count - wanted_frames ) & ( MAX_PROFILE_FRAMES - 1 ) ] : 0;
+
+    fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    bool first_event = true;
+    const int rings = number_of_profile_rings.load( std::memory_order_acquire );
+    for ( int ring = 0; ring < rings; ++ring )
+    {
+        profiler_write_ring( file, profile_rings[ ring ], since, &first_event );
+    }
+
+    const uint64_t first_frame = ( frame_count > MAX_PROFILE_FRAMES ) ? frame_count - MAX_PROFILE_FRAMES : 0;
+    for ( uint64_t frame = first_frame; frame < frame_count; ++frame )
+    {
+        const uint64_t time = profile_frames[ frame & ( MAX_PROFILE_FRAMES - 1 ) ];
+        if ( time >= since )
+        {
+            fprintf( file, "%s{\"name\":\"frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}", ( first_event ) ? "" : ",\n", ( unsigned long long )( frame ), time / 1000.0 );
+            first_event = false;
+        }
+    }
+    fprintf( file, "\n]}\n" );
+    fclose( file );
+    return true;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+// Rings are handed out once per thread & ne’er given back, so a thread’s first zone is its only slow one.
+static ProfileRing* profiler_get_thread_ring()
+{
+    if ( !thread_ring )
+    {
+        const int ring = number_of_profile_rings.fetch_add( 1, std::memory_order_acq_rel );
+        if ( ring >= MAX_PROFILE_THREADS )
+        {
+            number_of_profile_rings.store( MAX_PROFILE_THREADS, std::memory_order_release );
+            return nullptr;
+        }
+        thread_ring = &profile_rings[ ring ];
+        thread_ring->thread_id = ring + 1;
+    }
+    return thread_ring;
+}
+
+// Another thread may be writing while this reads, so events it might have lapped since are skipped.
+static void profiler_write_ring( FILE* file, ProfileRing& ring, uint64_t since, bool* first_event )
+{
+    const uint64_t head = ring.head.load( std::memory_order_acquire );
+    const uint64_t first = ( head > PROFILE_RING_SIZE ) ? head - PROFILE_RING_SIZE : 0;
+    for ( uint64_t i = first; i < head; ++i )
+    {
+        const ProfileEvent event = ring.events[ i & ( PROFILE_RING_SIZE - 1 ) ];
+        if ( ring.head.load( std::memory_order_acquire ) - i > PROFILE_RING_SIZE )
+        {
+            continue;
+        }
+        if ( event.begin < since )
+        {
+            continue;
+        }
+        fprintf
+        (
+            file,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            ( *first_event ) ? "" : ",\n",
+            event.name,
+            event.begin / 1000.0,
+            ( event.end - event.begin ) / 1000.0,
+            ring.thread_id
+        );
+        *first_event = false;
+    }
+}
+
+#endif
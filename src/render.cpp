@@ -1,22 +1,55 @@
 #include "config.hpp"
 #include <cstdio>
+#include "frame_histogram.hpp"
 #include "glad.h"
 #include "glfw3.h"
+#include "gpu_timer.hpp"
 #include "glm.hpp"
 #include "glm/ext/matrix_clip_space.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "ogl_error.hpp"
+#include "palette.hpp"
+#include "profiler.hpp"
 #include "rect.hpp"
 #include "render.hpp"
+#include "shader.hpp"
+#include "soft_render.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstring>
+#include <string>
 
 #include <unordered_map>
 
 
-#define PALETTE_COLORS 256
-#define CHANNELS_PER_COLOR 4
-#define MAX_TEXTURES 50
+#define MAX_TEXTURES 512
 #define MAX_FILENAME 255
+#define ATLAS_HEADER_SIZE 8
+#define MAX_ATLAS_PAGES 16
+#define MAX_ATLAS_TILES 4096
+#define ATLAS_SPRITE_SIZE 20
+#define ATLAS_TILE_SIZE 6
+#define ATLAS_EMPTY_TILE 0xFFFF
+#define MAX_BATCH_SPRITES 2048
+#define VERTICES_PER_SPRITE 4
+#define INDICES_PER_SPRITE 6
+#define INDEXED_FRAMEBUFFER_TEXTURE_UNIT 2
+#define SCANLINE_TEXTURE_UNIT 3
+#define SCANLINE_TEXELS 2
+#define NO_SCANLINE_PALETTE -1
+
+// Sprite shader features, used as bits o’ a variant key. Rotation & flips are baked into the batched vertices,
+// so they ne’er need a variant.
+constexpr unsigned int SPRITE_FEATURE_ALPHA = 1u << 0;
+constexpr unsigned int SPRITE_FEATURE_PALETTE_OFFSET = 1u << 1;
+constexpr unsigned int SPRITE_FEATURE_SCANLINES = 1u << 2;
+constexpr unsigned int SPRITE_FEATURE_INDEXED_OUTPUT = 1u << 3;
+constexpr int SPRITE_FEATURE_COUNT = 4;
+constexpr int SPRITE_SHADER_VARIANTS = 1 << SPRITE_FEATURE_COUNT;
+
+struct SpriteVertex;
 
 
 //
@@ -24,11 +57,32 @@
 //
 ///////////////////////////////////////////////////////////
 
-static unsigned int createShader( const char* vertex_shader_code, const char* fragment_shader_code );
-static unsigned int compileShader( unsigned int type, const char* source );
-static const char* getShaderTypeText( unsigned int type );
 static void render_init_texture_buffer();
-static void render_init_palette();
+static void render_flush_sprites();
+static unsigned int render_get_sprite_shader( unsigned int features );
+static void render_submit_sprite_shader( unsigned int features );
+static void render_finish_sprite_shader( unsigned int features );
+static void render_finish_ready_sprite_shaders();
+static void render_finish_rect_shader();
+static void render_finish_resolve_shader();
+static void render_init_indexed_framebuffer();
+static void render_resolve_indexed_framebuffer();
+static void render_init_scanlines();
+static void render_upload_scanlines();
+static void render_set_scanline_scale( float scale );
+static void render_mark_scanline_dirty( int line );
+static void render_bind_vertex_array( unsigned int vao );
+static void render_bind_sprite_texture( unsigned int texture_id );
+static void render_finish_frame_stats( double submit_seconds );
+static void render_finish_load_stats( const RenderLoadStats& before, double load_start );
+static void render_texture_piece( unsigned int texture_id, const unsigned char* page_buffer, int page_width, int page_height, const Rect& box, int page_x, int page_y, const Rect& src, const Rect& dest, int palette, bool flip_x, bool flip_y, float rotation, float alpha, float rotation_origin_x, float rotation_origin_y );
+static void render_push_sprite( unsigned int texture_id, const unsigned char* page_buffer, int page_width, int page_height, const SpriteVertex* vertices );
+static unsigned char* render_read_file( const char* filename, long* file_size );
+static bool render_keep_image_indices( const char* name, Texture texture );
+static bool render_check_atlas( const char* filename, const unsigned char* data, const unsigned char* file_end, int number_of_pages, int number_of_sprites );
+static unsigned int render_create_texture( int width, int height, const unsigned char* indices );
+static unsigned char* render_copy_indices( const unsigned char* indices, size_t count );
+static int read_u16( const unsigned char* data );
 
 
 
@@ -49,57 +103,140 @@ const char* rect_vertex_shader_code =
     "   gl_Position = u_MVP * position;\n"
     "}";
 
+// Rects drawn with a palette colour (u_Index > 0) take it from the scanline’s palette row if it has one.
 const char* rect_fragment_shader_code =
     "#version 330 core\n"
     "\n"
     "layout(location = 0) out vec4 color;\n"
     "\n"
     "uniform vec4 u_Color;\n"
+    "uniform int u_Index;\n"
+    "uniform sampler2D u_Palette;\n"
+    "uniform sampler2D u_Scanlines;\n"
+    "uniform float u_ScanlineScale;\n"
     "\n"
     "void main()\n"
     "{\n"
-    "   color = u_Color;\n"
+    "   int lines = textureSize( u_Scanlines, 0 ).y;\n"
+    "   int line = clamp( lines - 1 - int( gl_FragCoord.y * u_ScanlineScale ), 0, lines - 1 );\n"
+    "   int row = int( texelFetch( u_Scanlines, ivec2( 0, line ), 0 ).r );\n"
+    "   color = ( u_Index > 0 && row >= 0 ) ? texelFetch( u_Palette, ivec2( u_Index, row ), 0 ) : u_Color;\n"
     "}";
 
 const char* sprite_vertex_shader_code =
     "#version 330 core\n"
     "\n"
-    "layout(location = 0) in vec4 position;\n"
+    "layout(location = 0) in vec2 position;\n"
     "layout(location = 1) in vec2 texCoord;\n"
+    "layout(location = 2) in float alpha;\n"
+    "layout(location = 3) in uvec2 palette;\n"
     "\n"
     "out vec2 v_TexCoord;\n"
+    "out float v_Alpha;\n"
+    "flat out uvec2 v_Palette;\n"
     "\n"
     "uniform mat4 u_MVP;\n"
-    "uniform vec2 u_CoordOffset;\n"
     "\n"
     "void main()\n"
     "{\n"
-    "   gl_Position = u_MVP * position;\n"
-    "   v_TexCoord = texCoord + u_CoordOffset;\n"
+    "   gl_Position = u_MVP * vec4( position, 0.0, 1.0 );\n"
+    "   v_TexCoord = texCoord;\n"
+    "   v_Alpha = alpha;\n"
+    "   v_Palette = palette;\n"
     "}";
 
-const char* sprite_fragment_shader_code =
-    "#version 330 core\n"
+// One source for every sprite fragment shader variant; each feature bit below adds a #define, so batches that
+// don’t need a feature ne’er pay for it. Indexed output writes the palette index itself for the indexed
+// framebuffer, where indices can’t blend, so alpha only decides whether a pixel is drawn at all.
+const char* sprite_fragment_shader_template =
     "\n"
     "layout(location = 0) out vec4 color;\n"
     "\n"
     "in vec2 v_TexCoord;\n"
+    "in float v_Alpha;\n"
+    "flat in uvec2 v_Palette;\n"
     "\n"
     "uniform sampler2D u_Palette;\n"
     "uniform sampler2D u_Texture;\n"
-    "uniform float u_PaletteIndex;\n"
-    "uniform float u_Alpha;\n"
+    "#ifdef SCANLINES\n"
+    "uniform sampler2D u_Scanlines;\n"
+    "uniform float u_ScanlineScale;\n"
+    "#endif\n"
     "\n"
     "void main()\n"
     "{\n"
-    "   vec4 texColor = texture2D(u_Texture, v_TexCoord);\n"
-    "   vec2 index = vec2( texColor.r + u_PaletteIndex, 0 );\n"
-    "   vec4 indexedColor = texture2D( u_Palette, index );\n"
-    "   indexedColor.a *= u_Alpha;\n"
+    "   int row = int( v_Palette.x );\n"
+    "#ifdef SCANLINES\n"
+    "   int lines = textureSize( u_Scanlines, 0 ).y;\n"
+    "   int line = clamp( lines - 1 - int( gl_FragCoord.y * u_ScanlineScale ), 0, lines - 1 );\n"
+    "   int line_row = int( texelFetch( u_Scanlines, ivec2( 0, line ), 0 ).r );\n"
+    "   row = ( line_row >= 0 ) ? line_row : row;\n"
+    "#endif\n"
+    "   int index = int( texture( u_Texture, v_TexCoord ).r * 255.0 + 0.5 );\n"
+    "#ifdef PALETTE_OFFSET\n"
+    "   index = min( index + int( v_Palette.y ), 255 );\n"
+    "#endif\n"
+    "   vec4 indexedColor = texelFetch( u_Palette, ivec2( index, row ), 0 );\n"
+    "#ifdef ALPHA\n"
+    "   indexedColor.a *= v_Alpha;\n"
+    "#endif\n"
+    "#ifdef INDEXED_OUTPUT\n"
+    "   if ( indexedColor.a < 0.5 )\n"
+    "   {\n"
+    "       discard;\n"
+    "   }\n"
+    "   color = vec4( float( index ) / 255.0, 0.0, 0.0, 1.0 );\n"
+    "#else\n"
     "   color = indexedColor;\n"
+    "#endif\n"
+    "}";
+
+static const char* sprite_feature_names[ SPRITE_FEATURE_COUNT ] = { "ALPHA", "PALETTE_OFFSET", "SCANLINES", "INDEXED_OUTPUT" };
+
+const char* resolve_vertex_shader_code =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) in vec4 position;\n"
+    "\n"
+    "out vec2 v_TexCoord;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4( position.xy * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "   v_TexCoord = position.xy;\n"
+    "}";
+
+// Each line o’ the screen reads the indexed framebuffer through its scanline’s offset & affine transform
+// ’round the screen’s centre, wrapping at the edges like a scrolling background layer would.
+const char* resolve_fragment_shader_code =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_TexCoord;\n"
+    "\n"
+    "uniform sampler2D u_Palette;\n"
+    "uniform sampler2D u_Indices;\n"
+    "uniform sampler2D u_Scanlines;\n"
+    "uniform int u_PaletteRow;\n"
+    "uniform vec4 u_BackgroundColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 size = vec2( textureSize( u_Indices, 0 ) );\n"
+    "   vec2 pixel = floor( vec2( v_TexCoord.x, 1.0 - v_TexCoord.y ) * size );\n"
+    "   int line = int( pixel.y );\n"
+    "   vec4 scanline = texelFetch( u_Scanlines, ivec2( 0, line ), 0 );\n"
+    "   vec4 affine = texelFetch( u_Scanlines, ivec2( 1, line ), 0 );\n"
+    "   vec2 center = size * 0.5;\n"
+    "   vec2 source = mat2( affine.x, affine.z, affine.y, affine.w ) * ( pixel + 0.5 - center ) + center + scanline.yz;\n"
+    "   ivec2 texel = ivec2( mod( floor( source ), size ) );\n"
+    "   texel.y = int( size.y ) - 1 - texel.y;\n"
+    "   int index = int( texelFetch( u_Indices, texel, 0 ).r * 255.0 + 0.5 );\n"
+    "   int row = ( scanline.x >= 0.0 ) ? int( scanline.x ) : u_PaletteRow;\n"
+    "   color = ( index == 0 ) ? u_BackgroundColor : vec4( texelFetch( u_Palette, ivec2( index, row ), 0 ).rgb, 1.0 );\n"
     "}";
 
-static float palette_colors[ PALETTE_COLORS ][ CHANNELS_PER_COLOR ] = {};
 static float background_color[ CHANNELS_PER_COLOR ] = { 0.0f, 0.5f, 1.0f, 1.0f };
 
 static float vertex_positions[ 16 ] = {
@@ -117,32 +254,105 @@ static unsigned int vertex_indices[ 6 ] =
 
 static GLFWwindow* window;
 static unsigned int rect_shader;
-static unsigned int sprite_shader;
-static unsigned int palette_id;
+static unsigned int sprite_shaders[ SPRITE_SHADER_VARIANTS ] = { 0 };
+static bool sprite_shader_finished[ SPRITE_SHADER_VARIANTS ] = { false };
+static bool first_frame_presented = false;
+static unsigned int resolve_shader;
 static glm::mat4 projection_matrix;
 static Rect canvas = { 0.0f, 0.0f, CONFIG_WINDOW_WIDTH_PIXELS, CONFIG_WINDOW_HEIGHT_PIXELS };
 
 static unsigned int texture_vao;
+static unsigned int texture_vbo;
 static unsigned int rect_vao;
-static int sprite_mvp_uniform_location;
-static int palette_index_uniform_location;
-static int sprite_alpha_uniform_location;
-static int sprite_coord_offset_uniform_location;
-static int rect_color_uniform_location;
-static int rect_mvp_uniform_location;
-
+static unsigned int indexed_framebuffer;
+static unsigned int indexed_framebuffer_texture;
+static bool indexed_framebuffer_requested = CONFIG_INDEXED_FRAMEBUFFER;
+static bool indexed_framebuffer_active = false;
+static int resolve_palette_row = 0;
+
+// Per line: ( palette row, x offset, y offset, unused ), then the affine matrix ( a, b, c, d ).
+static float scanlines[ CONFIG_WINDOW_HEIGHT_PIXELS ][ SCANLINE_TEXELS ][ 4 ];
+static unsigned int scanline_texture;
+static int scanline_dirty_first = 0;
+static int scanline_dirty_last = CONFIG_WINDOW_HEIGHT_PIXELS - 1;
+static float scanline_scale = 0.0f;
+static bool scanline_palette_active = false;
+
+// An image is either its own GL texture, a trimmed region o’ an atlas page, or a tileset whose deduplicated tiles
+// are scattered ’cross atlas pages. width & height are always the untrimmed source size, so src rects stay in source coordinates.
 struct TextureData
 {
     unsigned int id;
     unsigned int framebuffer;
     int width;
     int height;
+    unsigned char* buffer; // Page's palette indices, bottom row first; only kept for CPU-readable textures.
+    int page_width;
+    int page_height;
+    int atlas_x;
+    int atlas_y;
+    int trim_x;
+    int trim_y;
+    int trim_width;
+    int trim_height;
+    int tile_size;
+    int first_tile;
+    bool in_atlas;
+};
+
+// Where one tile o’ a tileset lives; tiles with identical pixels point at the same spot.
+struct AtlasTile
+{
+    unsigned int id;
+    int page_width;
+    int page_height;
+    int x;
+    int y;
     unsigned char* buffer;
 };
 
 static std::unordered_map<std::string, int> texture_map;
 static TextureData textures[ MAX_TEXTURES ];
 static Texture number_of_textures = 0;
+static AtlasTile atlas_tiles[ MAX_ATLAS_TILES ];
+static int number_of_atlas_tiles = 0;
+static size_t texture_gpu_bytes = 0;
+static size_t texture_cpu_bytes_kept = 0;
+static size_t texture_cpu_bytes_dropped = 0;
+
+// One corner o’ a batched sprite, already transformed into canvas coordinates.
+struct SpriteVertex
+{
+    float x;
+    float y;
+    float u;
+    float v;
+    float alpha;
+    unsigned short palette_row;
+    unsigned short palette_offset;
+};
+
+// Sprites pile up here & go out in one draw call per run o’ sprites sharing a texture.
+static SpriteVertex sprite_batch[ MAX_BATCH_SPRITES * VERTICES_PER_SPRITE ];
+static int sprite_batch_count = 0;
+static unsigned int sprite_batch_texture = 0;
+static unsigned int sprite_batch_features = 0;
+static int sprite_batch_limit = MAX_BATCH_SPRITES;
+
+// Bindings we made last, so redundant ones can be skipped; texture unit 1 only ever holds sprite textures.
+static unsigned int bound_vertex_array = 0;
+static unsigned int bound_sprite_texture = 0;
+
+// Counters here run from startup; render_present turns them, & the shader & palette totals, into the last frame’s stats.
+static RenderStats render_stats_total = {};
+static RenderStats render_stats_at_frame_end = {};
+static ShaderStats shader_stats_at_frame_end = {};
+static size_t palette_bytes_at_frame_end = 0;
+static RenderStats last_frame_stats = {};
+static double frame_submit_start = 0.0;
+static size_t render_target_bytes = 0;
+static RenderLoadStats render_load_stats = {};
+static double last_present_time = -1.0;
 
 //
 //  PUBLIC FUNCTIONS
@@ -151,63 +361,152 @@ static Texture number_of_textures = 0;
 
 void render_texture( Texture texture, const Rect& src, const Rect& dest, int palette, bool flip_x, bool flip_y, float rotation, float alpha, float rotation_origin_x, float rotation_origin_y )
 {
-    glActiveTexture( GL_TEXTURE1 );
-    glBindTexture( GL_TEXTURE_2D, textures[ texture ].id );
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 64, 32, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
-    glBindTexture( GL_TEXTURE_2D, 0 );
-    if ( flip_x )
+    PROFILE_ZONE( "render_texture" );
+    const TextureData& data = textures[ texture ];
+    if ( data.tile_size == 0 )
     {
-        rotation_origin_x *= -1.0f;
+        const Rect trimmed = { ( float )( data.trim_x ), ( float )( data.trim_y ), ( float )( data.trim_width ), ( float )( data.trim_height ) };
+        render_texture_piece( data.id, data.buffer, data.page_width, data.page_height, trimmed, data.atlas_x, data.atlas_y, src, dest, palette, flip_x, flip_y, rotation, alpha, rotation_origin_x, rotation_origin_y );
+        return;
     }
-    if ( flip_y )
+
+    // Tilesets are drawn tile by tile, since neighbouring tiles needn’t be neighbours in the atlas.
+    const int columns = ( data.width + data.tile_size - 1 ) / data.tile_size;
+    const int rows = ( data.height + data.tile_size - 1 ) / data.tile_size;
+    const int first_column = std::max( 0, ( int )( src.x ) / data.tile_size );
+    const int first_row = std::max( 0, ( int )( src.y ) / data.tile_size );
+    const int last_column = std::min( columns - 1, ( ( int )( std::ceil( rect_right( src ) ) ) - 1 ) / data.tile_size );
+    const int last_row = std::min( rows - 1, ( ( int )( std::ceil( rect_bottom( src ) ) ) - 1 ) / data.tile_size );
+    for ( int row = first_row; row <= last_row; ++row )
     {
-        rotation_origin_y *= -1.0f;
+        for ( int column = first_column; column <= last_column; ++column )
+        {
+            const AtlasTile& tile = atlas_tiles[ data.first_tile + row * columns + column ];
+            if ( tile.id == 0 )
+            {
+                continue;
+            }
+            const Rect cell =
+            {
+                ( float )( column * data.tile_size ),
+                ( float )( row * data.tile_size ),
+                ( float )( std::min( data.tile_size, data.width - column * data.tile_size ) ),
+                ( float )( std::min( data.tile_size, data.height - row * data.tile_size ) )
+            };
+            render_texture_piece( tile.id, tile.buffer, tile.page_width, tile.page_height, cell, tile.x, tile.y, src, dest, palette, flip_x, flip_y, rotation, alpha, rotation_origin_x, rotation_origin_y );
+        }
     }
+}
 
-    glUseProgram( sprite_shader );
-    glm::mat4 view_matrix = glm::translate( glm::mat4( 1.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ) );
+void render_texture_pieces( Texture texture, const SpritePiece* pieces, int count, float x, float y, int palette )
+{
+    const TextureData& data = textures[ texture ];
+    if ( data.tile_size != 0 )
+    {
+        for ( int i = 0; i < count; ++i )
+        {
+            const Rect dest = { x + pieces[ i ].x, y + pieces[ i ].y, pieces[ i ].src.w, pieces[ i ].src.h };
+            render_texture( texture, pieces[ i ].src, dest, palette );
+        }
+        return;
+    }
 
-    glm::mat4 model_matrix = glm::mat4( 1.0f );
-    model_matrix = glm::translate( model_matrix, glm::vec3( dest.x, dest.y, 0.0f ) );
-    model_matrix = glm::translate( model_matrix, glm::vec3( rotation_origin_x, rotation_origin_y, 0.0f ) );
-    model_matrix = glm::rotate( model_matrix, glm::radians( rotation ), glm::vec3( 0.0f, 0.0f, 1.0f ) );
-    model_matrix = glm::translate( model_matrix, glm::vec3( -rotation_origin_x, -rotation_origin_y, 0.0f ) );
-    model_matrix = glm::scale( model_matrix, glm::vec3( 64.0f * ( ( flip_x ) ? -1.0f : 1.0f ), 16.0f * ( ( flip_y ) ? -1.0f : 1.0f ), 0.0f ) );
-    rotation += 1.0f;
-    glm::mat4 mvp = projection_matrix * view_matrix * model_matrix;
-    glUniformMatrix4fv( sprite_mvp_uniform_location, 1, GL_FALSE, &mvp[ 0 ][ 0 ] );
-    glUniform1f( palette_index_uniform_location, ( 1.0f / 255.0f ) * 8.0f * ( float )( palette ) );
-    glUniform1f( sprite_alpha_uniform_location, alpha );
-    glUniform2f( sprite_coord_offset_uniform_location, 0.0f, 0.0f );
-    glBindTexture( GL_TEXTURE_2D, textures[ texture ].id );
-    ogl_clear_error();
-    glTexSubImage2D( GL_TEXTURE_2D, 0, 16, 0, 32, 32, GL_RGBA, GL_UNSIGNED_BYTE, textures[ texture ].buffer );
-    ogl_check_error();
-    ogl_call( glBindVertexArray( texture_vao ) );
-    ogl_call( glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr ) );
+    // Same clipping & texture coordinates as render_texture_piece, minus the scaling, flips & rotation.
+    const float trim_right = ( float )( data.trim_x + data.trim_width );
+    const float trim_bottom = ( float )( data.trim_y + data.trim_height );
+    const unsigned short palette_row = ( unsigned short )( palette_id_row( palette ) );
+    const unsigned short palette_offset = ( unsigned short )( palette_id_bank( palette ) * PALETTE_BANK_COLORS );
+    for ( int i = 0; i < count; ++i )
+    {
+        const Rect& src = pieces[ i ].src;
+        const float left = std::max( src.x, ( float )( data.trim_x ) );
+        const float top = std::max( src.y, ( float )( data.trim_y ) );
+        const float right = std::min( rect_right( src ), trim_right );
+        const float bottom = std::min( rect_bottom( src ), trim_bottom );
+        if ( right <= left || bottom <= top )
+        {
+            ++render_stats_total.sprites_culled;
+            continue;
+        }
+
+        const float dest_left = x + pieces[ i ].x + left - src.x;
+        const float dest_top = y + pieces[ i ].y + top - src.y;
+        const float dest_right = dest_left + right - left;
+        const float dest_bottom = dest_top + bottom - top;
+        const float u_left = ( data.atlas_x + left - data.trim_x ) / data.page_width;
+        const float u_right = ( data.atlas_x + right - data.trim_x ) / data.page_width;
+        const float v_top = 1.0f - ( data.atlas_y + top - data.trim_y ) / data.page_height;
+        const float v_bottom = 1.0f - ( data.atlas_y + bottom - data.trim_y ) / data.page_height;
+        const SpriteVertex vertices[ VERTICES_PER_SPRITE ] =
+        {
+            { dest_left, dest_top, u_left, v_top, 1.0f, palette_row, palette_offset },
+            { dest_right, dest_top, u_right, v_top, 1.0f, palette_row, palette_offset },
+            { dest_right, dest_bottom, u_right, v_bottom, 1.0f, palette_row, palette_offset },
+            { dest_left, dest_bottom, u_left, v_bottom, 1.0f, palette_row, palette_offset }
+        };
+        render_push_sprite( data.id, data.buffer, data.page_width, data.page_height, vertices );
+    }
 }
 
 void render_rect( const Rect& rect, int color )
 {
-    glUseProgram( rect_shader );
+#if CONFIG_SOFTWARE_RENDERER
+    soft_render_rect( rect, color );
+#endif
+    render_flush_sprites();
+    shader_use_program( rect_shader );
     glm::mat4 view_matrix = glm::translate( glm::mat4( 1.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ) );
     glm::mat4 model_matrix = glm::scale( glm::translate( glm::mat4( 1.0f ), glm::vec3( rect.x, rect.y, 0.0f ) ), glm::vec3( rect.w, rect.h, 0.0f ) );
     glm::mat4 mvp = projection_matrix * view_matrix * model_matrix;
-    glUniformMatrix4fv( rect_mvp_uniform_location, 1, GL_FALSE, &mvp[ 0 ][ 0 ] );
-    if ( color == 0 ) // If 0, color in background ’stead.
+    shader_set_mat4( rect_shader, SHADER_NAME( "u_MVP" ), &mvp[ 0 ][ 0 ] );
+    shader_set_int( rect_shader, SHADER_NAME( "u_Index" ), ( indexed_framebuffer_active ) ? 0 : color );
+    if ( indexed_framebuffer_active ) // Index goes straight into the red channel; 0 resolves to the background.
     {
-        ogl_call( glUniform4f( rect_color_uniform_location, background_color[ 0 ], background_color[ 1 ], background_color[ 2 ], background_color[ 3 ] ) );
+        shader_set_vec4( rect_shader, SHADER_NAME( "u_Color" ), color / 255.0f, 0.0f, 0.0f, 1.0f );
+    }
+    else if ( color == 0 ) // If 0, color in background ’stead.
+    {
+        shader_set_vec4( rect_shader, SHADER_NAME( "u_Color" ), background_color[ 0 ], background_color[ 1 ], background_color[ 2 ], background_color[ 3 ] );
     }
     else
     {
-        ogl_call( glUniform4f( rect_color_uniform_location, palette_colors[ color ][ 0 ], palette_colors[ color ][ 1 ], palette_colors[ color ][ 2 ], palette_colors[ color ][ 3 ] ) );
+        const unsigned char* palette_color = palette_get_color( 0, color );
+        shader_set_vec4( rect_shader, SHADER_NAME( "u_Color" ), palette_color[ 0 ] / 255.0f, palette_color[ 1 ] / 255.0f, palette_color[ 2 ] / 255.0f, palette_color[ 3 ] / 255.0f );
     }
-    ogl_call( glBindVertexArray( rect_vao ) );
+    render_bind_vertex_array( rect_vao );
+    GPU_TIMER_BEGIN( GPU_PASS_RECTS );
     ogl_call( glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr ) );
+    ++render_stats_total.draw_calls;
 }
 
-Texture render_get_texture( const char* name )
+Texture render_get_texture( const char* name, bool cpu_readable )
 {
+    PROFILE_ZONE( "render_get_texture" );
+    // Atlas sprites & already-loaded images are found by name without touching the disk, unless they’re wanted
+    // CPU-readable now but weren’t kept that way.
+    const RenderLoadStats load_stats_before = render_load_stats;
+    const double load_start = glfwGetTime();
+    const auto loaded = texture_map.find( name );
+    if ( loaded != texture_map.end() )
+    {
+        const TextureData& data = textures[ loaded->second ];
+        if ( !cpu_readable || data.buffer )
+        {
+            return loaded->second;
+        }
+        if ( data.in_atlas )
+        {
+            printf( "Texture %s is an atlas sprite that wasn’t loaded CPU-readable; load its atlas CPU-readable ’stead.\n", name );
+            return -1;
+        }
+        if ( !render_keep_image_indices( name, loaded->second ) )
+        {
+            return -1;
+        }
+        render_finish_load_stats( load_stats_before, load_start );
+        return loaded->second;
+    }
+
     char full_filename[ MAX_FILENAME + 9 ] = "bin/";
     strcat( full_filename, name );
     strcat( full_filename, ".jwi" );
@@ -223,75 +522,246 @@ Texture render_get_texture( const char* name )
     //glBindFramebuffer( GL_FRAMEBUFFER, framebuffer );
     //ogl_check_error();
 
-    unsigned int texture_id;
-    glGenTextures( 1, &texture_id );
-    glActiveTexture( GL_TEXTURE1 );
-    glBindTexture( GL_TEXTURE_2D, texture_id );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-
-    FILE* gfx_file;
     long file_size;
-    unsigned char* file_buffer;
-    size_t fread_flag;
-    gfx_file = fopen( full_filename, "rb" );
-    if ( !gfx_file )
+    unsigned char* file_buffer = render_read_file( full_filename, &file_size );
+    if ( !file_buffer )
     {
-        printf( "File didn’t load: %s\n", full_filename );
         return -1;
     }
+
+    int texture_width = read_u16( &file_buffer[ 0 ] );
+    int texture_height = read_u16( &file_buffer[ 2 ] );
+    unsigned char* texture_buffer = nullptr;
+    unsigned int texture_id = 0;
+
+    const size_t image_data_size = file_size - 4;
+
+    if ( image_data_size != ( size_t )( texture_width * texture_height ) )
+    {
+        printf( "GFX Load Error: File data doesn’t match width & height given!\n" );
+    }
     else
     {
-        fseek( gfx_file, 0, SEEK_END );
-        file_size = ftell( gfx_file );
-        rewind( gfx_file );
-        file_buffer = ( unsigned char* )( malloc( sizeof( unsigned char ) * file_size ) );
-        if ( !file_buffer )
+        // Upload once here; drawing only ever samples a region o’ it, so the CPU copy is only kept if asked for.
+        texture_id = render_create_texture( texture_width, texture_height, &file_buffer[ 4 ] );
+        if ( cpu_readable || CONFIG_SOFTWARE_RENDERER )
         {
-            printf( "Somehow run out o’ memory for loading file %s\n", full_filename );
+            texture_buffer = render_copy_indices( &file_buffer[ 4 ], image_data_size );
         }
-        fread_flag = fread( file_buffer, 1, file_size, gfx_file );
-        if ( ( long )( fread_flag ) != file_size )
+        else
         {
-            fputs( "Reading error", stderr );
+            texture_cpu_bytes_dropped += image_data_size;
         }
+    }
+
+    textures[ number_of_textures ] =
+    {
+        texture_id,
+        framebuffer,
+        texture_width,
+        texture_height,
+        texture_buffer,
+        texture_width,
+        texture_height,
+        0,
+        0,
+        0,
+        0,
+        texture_width,
+        texture_height,
+        0,
+        0,
+        false
+    };
+    texture_map[ name ] = number_of_textures;
+    ++number_of_textures;
+
+    free( file_buffer );
+    render_finish_load_stats( load_stats_before, load_start );
+    return number_of_textures - 1;
+}
+
+bool render_load_atlas( const char* name, bool cpu_readable )
+{
+    PROFILE_ZONE( "render_load_atlas" );
+    const RenderLoadStats load_stats_before = render_load_stats;
+    const double load_start = glfwGetTime();
+    char full_filename[ MAX_FILENAME + 9 ] = "bin/";
+    strcat( full_filename, name );
+    strcat( full_filename, ".jwa" );
 
-        int texture_width = ( ( unsigned int )( file_buffer[ 0 ] ) << 8 ) | file_buffer[ 1 ];
-        int texture_height = ( ( unsigned int )( file_buffer[ 2 ] ) << 8 ) | file_buffer[ 3 ];
-        unsigned char* texture_buffer = nullptr;
+    long file_size;
+    unsigned char* file_buffer = render_read_file( full_filename, &file_size );
+    if ( !file_buffer )
+    {
+        return false;
+    }
 
-        const size_t image_data_size = file_size - 4;
+    if ( file_size < ATLAS_HEADER_SIZE || memcmp( file_buffer, "JWA\x02", 4 ) != 0 )
+    {
+        printf( "Atlas Load Error: %s isn’t a valid atlas file.\n", full_filename );
+        free( file_buffer );
+        return false;
+    }
 
-        if ( image_data_size != ( size_t )( texture_width * texture_height ) )
+    const int number_of_pages = read_u16( &file_buffer[ 4 ] );
+    const int number_of_sprites = read_u16( &file_buffer[ 6 ] );
+    if ( number_of_pages > MAX_ATLAS_PAGES )
+    {
+        printf( "Atlas %s has too many pages: %d.\n", name, number_of_pages );
+        free( file_buffer );
+        return false;
+    }
+    if ( number_of_textures + number_of_sprites > MAX_TEXTURES )
+    {
+        printf( "Not ’nough room for atlas %s’s %d sprites.\n", name, number_of_sprites );
+        free( file_buffer );
+        return false;
+    }
+
+    // Everything’s checked up front, so a bad file’s turned away ’fore any page is uploaded or sprite named.
+    const unsigned char* data = &file_buffer[ ATLAS_HEADER_SIZE ];
+    const unsigned char* const file_end = file_buffer + file_size;
+    if ( !render_check_atlas( full_filename, data, file_end, number_of_pages, number_of_sprites ) )
+    {
+        free( file_buffer );
+        return false;
+    }
+
+    unsigned int page_ids[ MAX_ATLAS_PAGES ];
+    int page_widths[ MAX_ATLAS_PAGES ];
+    int page_heights[ MAX_ATLAS_PAGES ];
+    unsigned char* page_buffers[ MAX_ATLAS_PAGES ];
+    for ( int page = 0; page < number_of_pages; ++page )
+    {
+        page_widths[ page ] = read_u16( &data[ 0 ] );
+        page_heights[ page ] = read_u16( &data[ 2 ] );
+        const size_t page_size = ( size_t )( page_widths[ page ] * page_heights[ page ] );
+        page_ids[ page ] = render_create_texture( page_widths[ page ], page_heights[ page ], &data[ 4 ] );
+        if ( cpu_readable || CONFIG_SOFTWARE_RENDERER )
         {
-            printf( "GFX Load Error: File data doesn’t match width & height given!\n" );
+            page_buffers[ page ] = render_copy_indices( &data[ 4 ], page_size );
         }
         else
         {
-            texture_buffer = ( unsigned char* )( calloc( image_data_size * 4, sizeof( unsigned char ) ) );
-            //memcpy( ( void* )( texture_buffer ), ( const void* )( &file_buffer[ 4 ] ), image_data_size );
-            for ( int i = 0; i < image_data_size; ++i )
-            {
-                texture_buffer[ i * 4 ] = file_buffer[ 4 + i ];
-            }
+            page_buffers[ page ] = nullptr;
+            texture_cpu_bytes_dropped += page_size;
         }
+        data += 4 + page_size;
+    }
 
+    for ( int sprite = 0; sprite < number_of_sprites; ++sprite )
+    {
+        const int name_length = data[ 0 ];
+        const std::string sprite_name( ( const char* )( &data[ 1 ] ), name_length );
+        data += 1 + name_length;
+        const int page = read_u16( &data[ 0 ] );
+        const int width = read_u16( &data[ 14 ] );
+        const int height = read_u16( &data[ 16 ] );
+        const int tile_size = read_u16( &data[ 18 ] );
         textures[ number_of_textures ] =
         {
-            texture_id,
-            framebuffer,
-            texture_width,
-            texture_height,
-            texture_buffer
+            page_ids[ page ],
+            0,
+            width,
+            height,
+            page_buffers[ page ],
+            page_widths[ page ],
+            page_heights[ page ],
+            read_u16( &data[ 2 ] ),
+            read_u16( &data[ 4 ] ),
+            read_u16( &data[ 10 ] ),
+            read_u16( &data[ 12 ] ),
+            read_u16( &data[ 6 ] ),
+            read_u16( &data[ 8 ] ),
+            tile_size,
+            number_of_atlas_tiles,
+            true
         };
+        texture_map[ sprite_name ] = number_of_textures;
         ++number_of_textures;
+        data += ATLAS_SPRITE_SIZE;
 
-        fclose( gfx_file );
-        free( file_buffer );
-        return number_of_textures - 1;
+        if ( tile_size > 0 )
+        {
+            const int number_of_tiles = ( ( width + tile_size - 1 ) / tile_size ) * ( ( height + tile_size - 1 ) / tile_size );
+            for ( int tile = 0; tile < number_of_tiles; ++tile )
+            {
+                const int tile_page = read_u16( &data[ 0 ] );
+                atlas_tiles[ number_of_atlas_tiles ] = ( tile_page == ATLAS_EMPTY_TILE )
+                    ? AtlasTile{ 0, 0, 0, 0, 0, nullptr }
+                    : AtlasTile{ page_ids[ tile_page ], page_widths[ tile_page ], page_heights[ tile_page ], read_u16( &data[ 2 ] ), read_u16( &data[ 4 ] ), page_buffers[ tile_page ] };
+                ++number_of_atlas_tiles;
+                data += ATLAS_TILE_SIZE;
+            }
+        }
     }
+
+    free( file_buffer );
+    render_finish_load_stats( load_stats_before, load_start );
+    return true;
+}
+
+int render_get_texture_pixel( Texture texture, int x, int y )
+{
+    const TextureData& data = textures[ texture ];
+    if ( x < 0 || y < 0 || x >= data.width || y >= data.height )
+    {
+        return 0;
+    }
+
+    const unsigned char* buffer = data.buffer;
+    int page_width = data.page_width;
+    int page_height = data.page_height;
+    int page_x = data.atlas_x + x - data.trim_x;
+    int page_y = data.atlas_y + y - data.trim_y;
+    if ( data.tile_size > 0 )
+    {
+        const int columns = ( data.width + data.tile_size - 1 ) / data.tile_size;
+        const AtlasTile& tile = atlas_tiles[ data.first_tile + ( y / data.tile_size ) * columns + x / data.tile_size ];
+        if ( tile.id == 0 )
+        {
+            return 0;
+        }
+        buffer = tile.buffer;
+        page_width = tile.page_width;
+        page_height = tile.page_height;
+        page_x = tile.x + x % data.tile_size;
+        page_y = tile.y + y % data.tile_size;
+    }
+    else if ( x < data.trim_x || y < data.trim_y || x >= data.trim_x + data.trim_width || y >= data.trim_y + data.trim_height )
+    {
+        return 0;
+    }
+
+    if ( !buffer )
+    {
+        printf( "Texture %d wasn’t loaded CPU-readable.\n", ( int )( texture ) );
+        return -1;
+    }
+    return buffer[ ( page_height - 1 - page_y ) * page_width + page_x ];
+}
+
+RenderStats render_get_stats()
+{
+    return last_frame_stats;
+}
+
+RenderLoadStats render_get_load_stats()
+{
+    return render_load_stats;
+}
+
+void render_print_memory_report()
+{
+    printf
+    (
+        "Textures: %d loaded, %zu bytes in VRAM, %zu bytes o’ CPU copies kept, %zu bytes dropped after upload.\n",
+        ( int )( number_of_textures ),
+        texture_gpu_bytes,
+        texture_cpu_bytes_kept,
+        texture_cpu_bytes_dropped
+    );
 }
 
 bool render_init_window()
@@ -320,15 +790,26 @@ void render_init_gfx()
     glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     projection_matrix = glm::ortho( 0.0f, 1.0f * CONFIG_WINDOW_WIDTH_PIXELS, 1.0f * CONFIG_WINDOW_HEIGHT_PIXELS, 0.0f, -1.0f, 1.0f );
 
-    rect_shader = createShader( rect_vertex_shader_code, rect_fragment_shader_code );
-    glUseProgram( rect_shader );
-    rect_color_uniform_location = glGetUniformLocation( rect_shader, "u_Color" );
-    dassert( rect_color_uniform_location != -1 );
-    rect_mvp_uniform_location = glGetUniformLocation( rect_shader, "u_MVP" );
-    dassert( rect_mvp_uniform_location != -1 );
+    // Every program is submitted up front so the driver can compile them while we set up everything else;
+    // nothing asks how they went till they’re needed.
+    ogl_init_debug_output();
+    shader_init();
+    rect_shader = shader_create_program( rect_vertex_shader_code, rect_fragment_shader_code );
+    resolve_shader = shader_create_program( resolve_vertex_shader_code, resolve_fragment_shader_code );
+    render_submit_sprite_shader( 0 );
+    render_submit_sprite_shader( SPRITE_FEATURE_INDEXED_OUTPUT );
+
+    // Driver threads can build the rest in the background; without them, they’re built the first time a batch needs them.
+    if ( shader_can_compile_in_parallel() )
+    {
+        for ( unsigned int features = 0; features < SPRITE_SHADER_VARIANTS; ++features )
+        {
+            render_submit_sprite_shader( features );
+        }
+    }
 
     glGenVertexArrays( 1, &rect_vao );
-    glBindVertexArray( rect_vao );
+    render_bind_vertex_array( rect_vao );
 
     unsigned int buffer;
     ogl_call( glGenBuffers( 1, &buffer ) );
@@ -343,395 +824,779 @@ void render_init_gfx()
     ogl_call( glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo ) );
     ogl_call( glBufferData( GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof( unsigned int ), vertex_indices, GL_STATIC_DRAW ) );
 
-    sprite_shader = createShader( sprite_vertex_shader_code, sprite_fragment_shader_code );
-    ogl_call( glUseProgram( sprite_shader ) );
-    int texture_uniform_location = glGetUniformLocation( sprite_shader, "u_Texture" );
-    assert( texture_uniform_location != -1 );
-    glUniform1i( texture_uniform_location, 1 );
-    sprite_alpha_uniform_location = glGetUniformLocation( sprite_shader, "u_Alpha" );
-    assert( sprite_alpha_uniform_location != -1 );
-    int palette_uniform_location = glGetUniformLocation( sprite_shader, "u_Palette" );
-    assert( palette_uniform_location != -1 );
-    glUniform1i( palette_uniform_location, 0 );
-    int sprite_mvp_uniform_location = glGetUniformLocation( sprite_shader, "u_MVP" );
-    assert( sprite_mvp_uniform_location != -1 );
-    palette_index_uniform_location = glGetUniformLocation( sprite_shader, "u_PaletteIndex" );
-    assert( palette_index_uniform_location != -1 );
-    sprite_coord_offset_uniform_location = glGetUniformLocation( sprite_shader, "u_CoordOffset" );
-    assert( sprite_coord_offset_uniform_location != -1 );
-
+#if CONFIG_SOFTWARE_RENDERER
+    soft_render_init( CONFIG_SOFTWARE_RENDERER_THREADS );
+#endif
     render_init_texture_buffer();
-    render_init_palette();
+    render_init_indexed_framebuffer();
+    render_init_scanlines();
+    palette_init();
+
+    render_finish_rect_shader();
+    render_finish_resolve_shader();
+    GPU_TIMER_INIT();
 };
 
 void render_present()
 {
+    PROFILE_ZONE( "render_present" );
+    render_flush_sprites();
+#if CONFIG_SOFTWARE_RENDERER
+    soft_render_present();
+#endif
+    if ( indexed_framebuffer_active )
+    {
+        render_resolve_indexed_framebuffer();
+    }
+    GPU_TIMER_END( GPU_PASS_FRAME );
+    render_finish_frame_stats( glfwGetTime() - frame_submit_start );
     ogl_call( glfwSwapBuffers( window ) );
+    ogl_flush_debug_messages();
+
+    const double present_time = glfwGetTime();
+#if CONFIG_FRAME_HISTOGRAM
+    frame_histogram_record( FRAME_CLOCK_CPU, last_frame_stats.cpu_submit_ms );
+    if ( last_present_time >= 0.0 )
+    {
+        frame_histogram_record( FRAME_CLOCK_PRESENT, ( present_time - last_present_time ) * 1000.0 );
+    }
+#endif
+    last_present_time = present_time;
+
+    if ( !first_frame_presented )
+    {
+        first_frame_presented = true;
+        if ( CONFIG_SHOW_SHADER_REPORT )
+        {
+            shader_print_report();
+            printf( "First frame presented %.2f ms after startup.\n", present_time * 1000.0 );
+        }
+    }
 }
 
 void render_start()
 {
+    PROFILE_FRAME();
+    PROFILE_ZONE( "render_start" );
+    frame_submit_start = glfwGetTime();
+    GPU_TIMER_BEGIN_FRAME();
+    GPU_TIMER_BEGIN( GPU_PASS_FRAME );
+    palette_upload_dirty_rows();
+    render_upload_scanlines();
+    render_finish_ready_sprite_shaders();
+#if CONFIG_SOFTWARE_RENDERER
+    soft_render_start();
+#endif
+
+    // Mode switches only take effect ’tween frames so a frame ne’er mixes indices & colours.
+    indexed_framebuffer_active = indexed_framebuffer_requested;
+    if ( indexed_framebuffer_active )
+    {
+        glBindFramebuffer( GL_FRAMEBUFFER, indexed_framebuffer );
+        glViewport( 0, 0, CONFIG_WINDOW_WIDTH_PIXELS, CONFIG_WINDOW_HEIGHT_PIXELS );
+        glDisable( GL_BLEND );
+        render_set_scanline_scale( 1.0f );
+    }
+    else
+    {
+        int window_width;
+        int window_height;
+        glfwGetFramebufferSize( window, &window_width, &window_height );
+        render_set_scanline_scale( ( float )( CONFIG_WINDOW_HEIGHT_PIXELS ) / ( float )( std::max( window_height, 1 ) ) );
+    }
+
     ogl_call( glClear( GL_COLOR_BUFFER_BIT ) );
     render_rect( canvas, 0 );
 }
 
+void render_set_indexed_framebuffer( bool enabled )
+{
+    indexed_framebuffer_requested = enabled;
+}
 
+void render_set_resolve_palette( int row )
+{
+    resolve_palette_row = row;
+}
 
-//
-//  PRIVATE FUNCTIONS
-//
-///////////////////////////////////////////////////////////
-
-static unsigned int createShader( const char* vertex_shader_code, const char* fragment_shader_code )
-{
-    unsigned int program = glCreateProgram();
-    unsigned int vertex_shader = compileShader( GL_VERTEX_SHADER, vertex_shader_code );
-    unsigned int fragment_shader = compileShader( GL_FRAGMENT_SHADER, fragment_shader_code );
-    glAttachShader( program, vertex_shader );
-    glAttachShader( program, fragment_shader );
-    glLinkProgram( program );
-    glValidateProgram( program );
-    glDeleteShader( vertex_shader );
-    glDeleteShader( fragment_shader );
-    return program;
-};
+void render_set_batch_limit( int sprites )
+{
+    render_flush_sprites();
+    sprite_batch_limit = std::max( 1, std::min( sprites, MAX_BATCH_SPRITES ) );
+}
 
-static unsigned int compileShader( unsigned int type, const char* source )
+void render_set_scanline_palette( int first_line, int count, int row )
 {
-    unsigned int id = glCreateShader( type );
-    glShaderSource( id, 1, &source, nullptr );
-    glCompileShader( id );
+    const int last_line = std::min( first_line + count, CONFIG_WINDOW_HEIGHT_PIXELS ) - 1;
+    for ( int line = std::max( first_line, 0 ); line <= last_line; ++line )
+    {
+        scanlines[ line ][ 0 ][ 0 ] = ( float )( row );
+        render_mark_scanline_dirty( line );
+    }
+}
 
-    int result;
-    glGetShaderiv( id, GL_COMPILE_STATUS, &result );
-    if ( result == GL_FALSE )
+void render_set_scanline_offset( int line, float x, float y )
+{
+    if ( line < 0 || line >= CONFIG_WINDOW_HEIGHT_PIXELS )
     {
-        int message_length;
-        glGetShaderiv( id, GL_INFO_LOG_LENGTH, &message_length );
-        char* message = ( char* )( alloca( message_length * sizeof( char ) ) );
-        glGetShaderInfoLog( id, message_length, &message_length, message );
-        printf( "Failed to compile %s shader: %s\n", getShaderTypeText( type ), message );
-        glDeleteShader( id );
-        return 0;
+        return;
     }
+    scanlines[ line ][ 0 ][ 1 ] = x;
+    scanlines[ line ][ 0 ][ 2 ] = y;
+    render_mark_scanline_dirty( line );
+}
 
-    return id;
-};
+void render_set_scanline_affine( int line, float a, float b, float c, float d )
+{
+    if ( line < 0 || line >= CONFIG_WINDOW_HEIGHT_PIXELS )
+    {
+        return;
+    }
+    scanlines[ line ][ 1 ][ 0 ] = a;
+    scanlines[ line ][ 1 ][ 1 ] = b;
+    scanlines[ line ][ 1 ][ 2 ] = c;
+    scanlines[ line ][ 1 ][ 3 ] = d;
+    render_mark_scanline_dirty( line );
+}
 
-static const char* getShaderTypeText( unsigned int type )
+void render_reset_scanlines()
 {
-    return ( type == GL_VERTEX_SHADER )
-        ? "vertex"
-        : "fragment";
-};
+    for ( int line = 0; line < CONFIG_WINDOW_HEIGHT_PIXELS; ++line )
+    {
+        const float identity[ SCANLINE_TEXELS ][ 4 ] = { { NO_SCANLINE_PALETTE, 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } };
+        memcpy( scanlines[ line ], identity, sizeof( identity ) );
+    }
+    scanline_dirty_first = 0;
+    scanline_dirty_last = CONFIG_WINDOW_HEIGHT_PIXELS - 1;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
 
 static void render_init_texture_buffer()
 {
     glGenVertexArrays( 1, &texture_vao );
-    glBindVertexArray( texture_vao );
+    render_bind_vertex_array( texture_vao );
 
-    unsigned int buffer;
-    glGenBuffers( 1, &buffer );
-    glBindBuffer( GL_ARRAY_BUFFER, buffer );
-    glBufferData( GL_ARRAY_BUFFER, 4 * 4 * sizeof( float ), vertex_positions, GL_STATIC_DRAW );\
+    glGenBuffers( 1, &texture_vbo );
+    glBindBuffer( GL_ARRAY_BUFFER, texture_vbo );
+    glBufferData( GL_ARRAY_BUFFER, sizeof( sprite_batch ), nullptr, GL_STREAM_DRAW );
 
     glEnableVertexAttribArray( 0 );
-    glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( float ) * 4, nullptr );
+    glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( SpriteVertex ), ( const void* )( offsetof( SpriteVertex, x ) ) );
 
     glEnableVertexAttribArray( 1 );
-    glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( float ) * 4, ( const void* )( sizeof( float ) * 2 ) );
+    glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( SpriteVertex ), ( const void* )( offsetof( SpriteVertex, u ) ) );
+
+    glEnableVertexAttribArray( 2 );
+    glVertexAttribPointer( 2, 1, GL_FLOAT, GL_FALSE, sizeof( SpriteVertex ), ( const void* )( offsetof( SpriteVertex, alpha ) ) );
+
+    glEnableVertexAttribArray( 3 );
+    glVertexAttribIPointer( 3, 2, GL_UNSIGNED_SHORT, sizeof( SpriteVertex ), ( const void* )( offsetof( SpriteVertex, palette_row ) ) );
+
+    // Every sprite is the same 2 triangles, so the index buffer ne’er changes.
+    static unsigned short batch_indices[ MAX_BATCH_SPRITES * INDICES_PER_SPRITE ];
+    for ( int sprite = 0; sprite < MAX_BATCH_SPRITES; ++sprite )
+    {
+        for ( int index = 0; index < INDICES_PER_SPRITE; ++index )
+        {
+            batch_indices[ sprite * INDICES_PER_SPRITE + index ] = ( unsigned short )( sprite * VERTICES_PER_SPRITE + vertex_indices[ index ] );
+        }
+    }
 
     unsigned int ibo;
     glGenBuffers( 1, &ibo );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof( unsigned int ), vertex_indices, GL_STATIC_DRAW );
-}
-
-static void render_init_palette()
-{
-    unsigned char palette_buffer[ PALETTE_COLORS * CHANNELS_PER_COLOR ] =
-    {
-        0, 0, 0, 0,
-        0, 0, 0, 255,
-        248, 56, 8, 255,
-        248, 152, 80, 255,
-        112, 64, 24, 255,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-
-        0, 0, 0, 0,
-        255,255,255,255,
-        226, 184, 255, 255,
-        154,  96, 246, 255,
-         81,  34, 177, 255,
-          9,   0,  38, 255,
-        0, 0, 0, 255,
-        0, 0, 0, 0,
-
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( batch_indices ), batch_indices, GL_STATIC_DRAW );
+}
+
+// Draws the part o’ src that falls inside box, a rectangle o’ the source image whose top-left pixel sits at page_x, page_y on the page.
+static void render_texture_piece( unsigned int texture_id, const unsigned char* page_buffer, int page_width, int page_height, const Rect& box, int page_x, int page_y, const Rect& src, const Rect& dest, int palette, bool flip_x, bool flip_y, float rotation, float alpha, float rotation_origin_x, float rotation_origin_y )
+{
+    // Clip src to the box, & shrink dest by the same amount so the sprite stays put.
+    const float left = std::max( src.x, box.x );
+    const float top = std::max( src.y, box.y );
+    const float right = std::min( rect_right( src ), rect_right( box ) );
+    const float bottom = std::min( rect_bottom( src ), rect_bottom( box ) );
+    if ( right <= left || bottom <= top )
+    {
+        ++render_stats_total.sprites_culled;
+        return;
+    }
+
+    const float scale_x = dest.w / src.w;
+    const float scale_y = dest.h / src.h;
+    const Rect quad =
+    {
+        ( ( flip_x ) ? rect_right( src ) - right : left - src.x ) * scale_x,
+        ( ( flip_y ) ? rect_bottom( src ) - bottom : top - src.y ) * scale_y,
+        ( right - left ) * scale_x,
+        ( bottom - top ) * scale_y
     };
-    ogl_call( glUseProgram( sprite_shader ) );
-    int palette_width = 256;
-    int palette_height = 1;
-    glGenTextures( 0, &palette_id );
-    glActiveTexture( GL_TEXTURE0 );
-    glBindTexture( GL_TEXTURE_2D, palette_id );
+
+    // Texture rows are stored bottom-up, so v counts from the bottom o’ the page.
+    const float u_left = ( page_x + left - box.x ) / page_width;
+    const float u_right = ( page_x + right - box.x ) / page_width;
+    const float v_top = 1.0f - ( page_y + top - box.y ) / page_height;
+    const float v_bottom = 1.0f - ( page_y + bottom - box.y ) / page_height;
+
+    const float u_quad_left = ( flip_x ) ? u_right : u_left;
+    const float u_quad_right = ( flip_x ) ? u_left : u_right;
+    const float v_quad_top = ( flip_y ) ? v_bottom : v_top;
+    const float v_quad_bottom = ( flip_y ) ? v_top : v_bottom;
+
+    // Rotate the quad’s corners ’round the origin, relative to dest, on the CPU so sprites needn’t each have their own matrix.
+    const float radians = glm::radians( rotation );
+    const float cosine = std::cos( radians );
+    const float sine = std::sin( radians );
+    const float corners[ VERTICES_PER_SPRITE ][ 4 ] =
+    {
+        { quad.x, quad.y, u_quad_left, v_quad_top },
+        { rect_right( quad ), quad.y, u_quad_right, v_quad_top },
+        { rect_right( quad ), rect_bottom( quad ), u_quad_right, v_quad_bottom },
+        { quad.x, rect_bottom( quad ), u_quad_left, v_quad_bottom }
+    };
+    const unsigned short palette_row = ( unsigned short )( palette_id_row( palette ) );
+    const unsigned short palette_offset = ( unsigned short )( palette_id_bank( palette ) * PALETTE_BANK_COLORS );
+    SpriteVertex vertices[ VERTICES_PER_SPRITE ];
+    for ( int corner = 0; corner < VERTICES_PER_SPRITE; ++corner )
+    {
+        const float x = corners[ corner ][ 0 ] - rotation_origin_x;
+        const float y = corners[ corner ][ 1 ] - rotation_origin_y;
+        vertices[ corner ] =
+        {
+            dest.x + rotation_origin_x + x * cosine - y * sine,
+            dest.y + rotation_origin_y + x * sine + y * cosine,
+            corners[ corner ][ 2 ],
+            corners[ corner ][ 3 ],
+            alpha,
+            palette_row,
+            palette_offset
+        };
+    }
+
+    render_push_sprite( texture_id, page_buffer, page_width, page_height, vertices );
+}
+
+// Sprites wholly off the canvas draw nothing, so they’re dropped ’fore they can cost a flush.
+static void render_push_sprite( unsigned int texture_id, const unsigned char* page_buffer, int page_width, int page_height, const SpriteVertex* vertices )
+{
+    float min_x = vertices[ 0 ].x;
+    float max_x = vertices[ 0 ].x;
+    float min_y = vertices[ 0 ].y;
+    float max_y = vertices[ 0 ].y;
+    for ( int corner = 1; corner < VERTICES_PER_SPRITE; ++corner )
+    {
+        min_x = std::min( min_x, vertices[ corner ].x );
+        max_x = std::max( max_x, vertices[ corner ].x );
+        min_y = std::min( min_y, vertices[ corner ].y );
+        max_y = std::max( max_y, vertices[ corner ].y );
+    }
+    if ( max_x <= canvas.x || min_x >= rect_right( canvas ) || max_y <= canvas.y || min_y >= rect_bottom( canvas ) )
+    {
+        ++render_stats_total.sprites_culled;
+        return;
+    }
+
+    if ( sprite_batch_count >= sprite_batch_limit || ( sprite_batch_count > 0 && sprite_batch_texture != texture_id ) )
+    {
+        render_flush_sprites();
+    }
+    sprite_batch_texture = texture_id;
+    sprite_batch_features |= ( ( vertices[ 0 ].alpha < 1.0f ) ? SPRITE_FEATURE_ALPHA : 0 ) | ( ( vertices[ 0 ].palette_offset != 0 ) ? SPRITE_FEATURE_PALETTE_OFFSET : 0 );
+    memcpy( &sprite_batch[ sprite_batch_count * VERTICES_PER_SPRITE ], vertices, VERTICES_PER_SPRITE * sizeof( SpriteVertex ) );
+    ++sprite_batch_count;
+    ++render_stats_total.sprites_submitted;
+
+#if CONFIG_SOFTWARE_RENDERER
+    SoftRenderCorner corners[ VERTICES_PER_SPRITE ];
+    for ( int corner = 0; corner < VERTICES_PER_SPRITE; ++corner )
+    {
+        corners[ corner ] = { vertices[ corner ].x, vertices[ corner ].y, vertices[ corner ].u, vertices[ corner ].v };
+    }
+    soft_render_sprite( { page_buffer, page_width, page_height }, corners, vertices[ 0 ].alpha, vertices[ 0 ].palette_row, vertices[ 0 ].palette_offset );
+#endif
+}
+
+static void render_flush_sprites()
+{
+    PROFILE_ZONE( "render_flush_sprites" );
+    if ( sprite_batch_count == 0 )
+    {
+        return;
+    }
+
+    // Each batch uses the cheapest variant that covers every sprite in it.
+    unsigned int features = sprite_batch_features;
+    features |= ( indexed_framebuffer_active ) ? SPRITE_FEATURE_INDEXED_OUTPUT : 0;
+    features |= ( scanline_palette_active ) ? SPRITE_FEATURE_SCANLINES : 0;
+    shader_use_program( render_get_sprite_shader( features ) );
+    render_bind_sprite_texture( sprite_batch_texture );
+    render_bind_vertex_array( texture_vao );
+    glBindBuffer( GL_ARRAY_BUFFER, texture_vbo );
+
+    // Orphan last batch’s storage so the driver needn’t wait on draws still reading it.
+    const size_t vertex_bytes = sprite_batch_count * VERTICES_PER_SPRITE * sizeof( SpriteVertex );
+    glBufferData( GL_ARRAY_BUFFER, sizeof( sprite_batch ), nullptr, GL_STREAM_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, vertex_bytes, sprite_batch );
+    GPU_TIMER_BEGIN( GPU_PASS_SPRITES );
+    ogl_call( glDrawElements( GL_TRIANGLES, sprite_batch_count * INDICES_PER_SPRITE, GL_UNSIGNED_SHORT, nullptr ) );
+    ++render_stats_total.draw_calls;
+    ++render_stats_total.batches;
+    render_stats_total.vertex_bytes_uploaded += vertex_bytes;
+    sprite_batch_count = 0;
+    sprite_batch_features = 0;
+}
+
+static unsigned int render_get_sprite_shader( unsigned int features )
+{
+    if ( sprite_shader_finished[ features ] )
+    {
+        return sprite_shaders[ features ];
+    }
+
+    // Till the exact variant is done compiling, any finished variant with extra features draws the same pixels,
+    // since alpha 1, bank 0 & lines without a palette override leave colours be. Output type must still match.
+    render_submit_sprite_shader( features );
+    if ( !shader_program_ready( sprite_shaders[ features ] ) )
+    {
+        for ( unsigned int candidate = 0; candidate < SPRITE_SHADER_VARIANTS; ++candidate )
+        {
+            if ( sprite_shader_finished[ candidate ] && ( candidate & features ) == features && ( ( candidate ^ features ) & SPRITE_FEATURE_INDEXED_OUTPUT ) == 0 )
+            {
+                return sprite_shaders[ candidate ];
+            }
+        }
+    }
+    render_finish_sprite_shader( features );
+    return sprite_shaders[ features ];
+}
+
+static void render_submit_sprite_shader( unsigned int features )
+{
+    if ( sprite_shaders[ features ] != 0 )
+    {
+        return;
+    }
+
+    std::string fragment_shader_code = "#version 330 core\n";
+    for ( int feature = 0; feature < SPRITE_FEATURE_COUNT; ++feature )
+    {
+        if ( features & ( 1u << feature ) )
+        {
+            fragment_shader_code += std::string( "#define " ) + sprite_feature_names[ feature ] + "\n";
+        }
+    }
+    fragment_shader_code += sprite_fragment_shader_template;
+    sprite_shaders[ features ] = shader_create_program( sprite_vertex_shader_code, fragment_shader_code.c_str() );
+}
+
+static void render_finish_sprite_shader( unsigned int features )
+{
+    unsigned int shader = sprite_shaders[ features ];
+    shader_finish_program( shader );
+    sprite_shader_finished[ features ] = true;
+
+    shader_set_int( shader, SHADER_NAME( "u_Texture" ), 1 );
+    shader_set_int( shader, SHADER_NAME( "u_Palette" ), 0 );
+    shader_set_int( shader, SHADER_NAME( "u_Scanlines" ), SCANLINE_TEXTURE_UNIT );
+    shader_set_float( shader, SHADER_NAME( "u_ScanlineScale" ), scanline_scale );
+
+    // Batched sprites arrive in canvas coordinates, so projection is all the sprite shader needs.
+    shader_set_mat4( shader, SHADER_NAME( "u_MVP" ), &projection_matrix[ 0 ][ 0 ] );
+}
+
+// Picks up variants the driver finished in the background, so they’re ready as stand-ins ’fore they’re needed.
+static void render_finish_ready_sprite_shaders()
+{
+    if ( !shader_can_compile_in_parallel() )
+    {
+        return;
+    }
+    for ( unsigned int features = 0; features < SPRITE_SHADER_VARIANTS; ++features )
+    {
+        if ( sprite_shaders[ features ] != 0 && !sprite_shader_finished[ features ] && shader_program_ready( sprite_shaders[ features ] ) )
+        {
+            render_finish_sprite_shader( features );
+        }
+    }
+}
+
+static void render_finish_rect_shader()
+{
+    shader_finish_program( rect_shader );
+    dassert( shader_get_uniform_location( rect_shader, SHADER_NAME( "u_Color" ) ) != -1 );
+    dassert( shader_get_uniform_location( rect_shader, SHADER_NAME( "u_MVP" ) ) != -1 );
+    shader_set_int( rect_shader, SHADER_NAME( "u_Palette" ), 0 );
+    shader_set_int( rect_shader, SHADER_NAME( "u_Scanlines" ), SCANLINE_TEXTURE_UNIT );
+}
+
+// An R8 target at the game’s native resolution: a quarter o’ the bandwidth o’ RGBA, & palette effects
+// on the whole screen only need the resolve pass to read a different row.
+static void render_init_indexed_framebuffer()
+{
+    glGenTextures( 1, &indexed_framebuffer_texture );
+    glActiveTexture( GL_TEXTURE0 + INDEXED_FRAMEBUFFER_TEXTURE_UNIT );
+    glBindTexture( GL_TEXTURE_2D, indexed_framebuffer_texture );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, CONFIG_WINDOW_WIDTH_PIXELS, CONFIG_WINDOW_HEIGHT_PIXELS, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr );
+    render_target_bytes += CONFIG_WINDOW_WIDTH_PIXELS * CONFIG_WINDOW_HEIGHT_PIXELS;
+
+    glGenFramebuffers( 1, &indexed_framebuffer );
+    glBindFramebuffer( GL_FRAMEBUFFER, indexed_framebuffer );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, indexed_framebuffer_texture, 0 );
+    if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+    {
+        printf( "Indexed framebuffer is incomplete; staying in direct color mode.\n" );
+        indexed_framebuffer_requested = false;
+    }
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+static void render_finish_resolve_shader()
+{
+    shader_finish_program( resolve_shader );
+    shader_set_int( resolve_shader, SHADER_NAME( "u_Palette" ), 0 );
+    shader_set_int( resolve_shader, SHADER_NAME( "u_Indices" ), INDEXED_FRAMEBUFFER_TEXTURE_UNIT );
+    shader_set_int( resolve_shader, SHADER_NAME( "u_Scanlines" ), SCANLINE_TEXTURE_UNIT );
+    shader_set_vec4( resolve_shader, SHADER_NAME( "u_BackgroundColor" ), background_color[ 0 ], background_color[ 1 ], background_color[ 2 ], background_color[ 3 ] );
+}
+
+static void render_resolve_indexed_framebuffer()
+{
+    int window_width;
+    int window_height;
+    glfwGetFramebufferSize( window, &window_width, &window_height );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    glViewport( 0, 0, window_width, window_height );
+    glEnable( GL_BLEND );
+
+    shader_use_program( resolve_shader );
+    shader_set_int( resolve_shader, SHADER_NAME( "u_PaletteRow" ), resolve_palette_row );
+    render_bind_vertex_array( rect_vao );
+    GPU_TIMER_BEGIN( GPU_PASS_RESOLVE );
+    ogl_call( glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr ) );
+    GPU_TIMER_END( GPU_PASS_RESOLVE );
+    ++render_stats_total.draw_calls;
+}
+
+// The scanline table lives in a float texture, 1 row per line, so raster effects cost one small upload a frame
+// ’stead o’ one draw per line.
+static void render_init_scanlines()
+{
+    glGenTextures( 1, &scanline_texture );
+    glActiveTexture( GL_TEXTURE0 + SCANLINE_TEXTURE_UNIT );
+    glBindTexture( GL_TEXTURE_2D, scanline_texture );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, palette_width, palette_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_buffer );
-    glBindTexture( GL_TEXTURE_2D, 0 );
-    glGenTextures( 0, &palette_id );
-    glBindTexture( GL_TEXTURE_2D, palette_id );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA32F, SCANLINE_TEXELS, CONFIG_WINDOW_HEIGHT_PIXELS, 0, GL_RGBA, GL_FLOAT, nullptr );
+    render_target_bytes += sizeof( scanlines );
+    render_reset_scanlines();
+    render_upload_scanlines();
+}
+
+static void render_upload_scanlines()
+{
+    if ( scanline_dirty_first > scanline_dirty_last )
+    {
+        return;
+    }
+    glActiveTexture( GL_TEXTURE0 + SCANLINE_TEXTURE_UNIT );
+    glBindTexture( GL_TEXTURE_2D, scanline_texture );
+    ogl_call( glTexSubImage2D( GL_TEXTURE_2D, 0, 0, scanline_dirty_first, SCANLINE_TEXELS, scanline_dirty_last - scanline_dirty_first + 1, GL_RGBA, GL_FLOAT, scanlines[ scanline_dirty_first ] ) );
+    render_stats_total.texture_bytes_uploaded += ( scanline_dirty_last - scanline_dirty_first + 1 ) * sizeof( scanlines[ 0 ] );
+#if CONFIG_SOFTWARE_RENDERER
+    for ( int line = scanline_dirty_first; line <= scanline_dirty_last; ++line )
+    {
+        const float ( &texels )[ SCANLINE_TEXELS ][ 4 ] = scanlines[ line ];
+        soft_render_set_scanline( line, ( int )( texels[ 0 ][ 0 ] ), texels[ 0 ][ 1 ], texels[ 0 ][ 2 ], texels[ 1 ][ 0 ], texels[ 1 ][ 1 ], texels[ 1 ][ 2 ], texels[ 1 ][ 3 ] );
+    }
+#endif
+
+    // Sprites only need the scanline lookup while some line actually overrides their palette row.
+    scanline_palette_active = false;
+    for ( int line = 0; line < CONFIG_WINDOW_HEIGHT_PIXELS && !scanline_palette_active; ++line )
+    {
+        scanline_palette_active = scanlines[ line ][ 0 ][ 0 ] != NO_SCANLINE_PALETTE;
+    }
+    scanline_dirty_first = CONFIG_WINDOW_HEIGHT_PIXELS;
+    scanline_dirty_last = -1;
+}
+
+// Shaders find their line from gl_FragCoord, which counts framebuffer pixels, so they need to know how many
+// o’ those make up a canvas line.
+static void render_set_scanline_scale( float scale )
+{
+    if ( scale == scanline_scale )
+    {
+        return;
+    }
+    scanline_scale = scale;
+    shader_set_float( rect_shader, SHADER_NAME( "u_ScanlineScale" ), scale );
+    for ( unsigned int features = 0; features < SPRITE_SHADER_VARIANTS; ++features )
+    {
+        if ( sprite_shader_finished[ features ] )
+        {
+            shader_set_float( sprite_shaders[ features ], SHADER_NAME( "u_ScanlineScale" ), scale );
+        }
+    }
+}
+
+static void render_mark_scanline_dirty( int line )
+{
+    scanline_dirty_first = std::min( scanline_dirty_first, line );
+    scanline_dirty_last = std::max( scanline_dirty_last, line );
+}
+
+static void render_bind_vertex_array( unsigned int vao )
+{
+    if ( vao == bound_vertex_array )
+    {
+        ++render_stats_total.state_changes_skipped;
+        return;
+    }
+    ogl_call( glBindVertexArray( vao ) );
+    bound_vertex_array = vao;
+    ++render_stats_total.state_changes;
+}
+
+static void render_bind_sprite_texture( unsigned int texture_id )
+{
+    if ( texture_id == bound_sprite_texture )
+    {
+        ++render_stats_total.state_changes_skipped;
+        return;
+    }
+    glActiveTexture( GL_TEXTURE1 );
+    glBindTexture( GL_TEXTURE_2D, texture_id );
+    bound_sprite_texture = texture_id;
+    ++render_stats_total.state_changes;
+}
+
+static void render_finish_frame_stats( double submit_seconds )
+{
+    const ShaderStats shader_stats = shader_get_stats();
+    const size_t palette_bytes = palette_get_bytes_uploaded();
+    const RenderStats& total = render_stats_total;
+    const RenderStats& before = render_stats_at_frame_end;
+    last_frame_stats =
+    {
+        total.draw_calls - before.draw_calls,
+        total.batches - before.batches,
+        total.sprites_submitted - before.sprites_submitted,
+        total.sprites_culled - before.sprites_culled,
+        total.state_changes - before.state_changes + ( int )( shader_stats.program_binds - shader_stats_at_frame_end.program_binds ) + ( int )( shader_stats.uniform_writes - shader_stats_at_frame_end.uniform_writes ),
+        total.state_changes_skipped - before.state_changes_skipped + ( int )( shader_stats.program_binds_skipped - shader_stats_at_frame_end.program_binds_skipped ) + ( int )( shader_stats.uniform_writes_skipped - shader_stats_at_frame_end.uniform_writes_skipped ),
+        total.texture_bytes_uploaded - before.texture_bytes_uploaded + palette_bytes - palette_bytes_at_frame_end,
+        total.vertex_bytes_uploaded - before.vertex_bytes_uploaded,
+        shader_stats.uniform_bytes - shader_stats_at_frame_end.uniform_bytes,
+        texture_gpu_bytes + render_target_bytes + PALETTE_ROWS * PALETTE_ROW_SIZE,
+        submit_seconds * 1000.0
+    };
+    render_stats_at_frame_end = render_stats_total;
+    shader_stats_at_frame_end = shader_stats;
+    palette_bytes_at_frame_end = palette_bytes;
+}
+
+// Whatever a load spent outside reading & uploading went to decoding.
+static void render_finish_load_stats( const RenderLoadStats& before, double load_start )
+{
+    const double total_ms = ( glfwGetTime() - load_start ) * 1000.0;
+    const double io_ms = ( render_load_stats.read_ms - before.read_ms ) + ( render_load_stats.upload_ms - before.upload_ms );
+    render_load_stats.decode_ms += std::max( 0.0, total_ms - io_ms );
+}
+
+static unsigned char* render_read_file( const char* filename, long* file_size )
+{
+    const double read_start = glfwGetTime();
+    FILE* file = fopen( filename, "rb" );
+    if ( !file )
+    {
+        printf( "File didn’t load: %s\n", filename );
+        return nullptr;
+    }
+
+    fseek( file, 0, SEEK_END );
+    *file_size = ftell( file );
+    rewind( file );
+    unsigned char* file_buffer = ( unsigned char* )( malloc( sizeof( unsigned char ) * *file_size ) );
+    if ( !file_buffer )
+    {
+        printf( "Somehow run out o’ memory for loading file %s\n", filename );
+        fclose( file );
+        return nullptr;
+    }
+    size_t fread_flag = fread( file_buffer, 1, *file_size, file );
+    if ( ( long )( fread_flag ) != *file_size )
+    {
+        fputs( "Reading error", stderr );
+    }
+    fclose( file );
+    ++render_load_stats.files;
+    render_load_stats.bytes_read += fread_flag;
+    render_load_stats.read_ms += ( glfwGetTime() - read_start ) * 1000.0;
+    return file_buffer;
+}
+
+// Re-reads an image first loaded without a CPU copy & keeps its indices.
+static bool render_keep_image_indices( const char* name, Texture texture )
+{
+    char full_filename[ MAX_FILENAME + 9 ] = "bin/";
+    strcat( full_filename, name );
+    strcat( full_filename, ".jwi" );
+
+    long file_size;
+    unsigned char* file_buffer = render_read_file( full_filename, &file_size );
+    if ( !file_buffer )
+    {
+        return false;
+    }
+
+    TextureData& data = textures[ texture ];
+    const size_t image_data_size = ( size_t )( data.width * data.height );
+    if ( ( size_t )( file_size - 4 ) != image_data_size )
+    {
+        printf( "GFX Load Error: File data doesn’t match width & height given!\n" );
+        free( file_buffer );
+        return false;
+    }
+    data.buffer = render_copy_indices( &file_buffer[ 4 ], image_data_size );
+    texture_cpu_bytes_dropped -= image_data_size;
+    free( file_buffer );
+    return true;
+}
 
-    // Set palette colors based on palette: unsigned byte -> float
-    for ( int color = 0; color < PALETTE_COLORS; ++color )
+// Walks an atlas’s pages, sprite records & tile tables without loading any o’ them, making sure each lies inside
+// the file, every page index names a page the atlas has, every sprite & tile lies inside its page, & there’s room
+// for the tiles. Tilesets’ own rects aren’t on any page; only their tiles are.
+static bool render_check_atlas( const char* filename, const unsigned char* data, const unsigned char* file_end, int number_of_pages, int number_of_sprites )
+{
+    int page_widths[ MAX_ATLAS_PAGES ];
+    int page_heights[ MAX_ATLAS_PAGES ];
+    for ( int page = 0; page < number_of_pages; ++page )
     {
-        for ( int channel = 0; channel < CHANNELS_PER_COLOR; ++channel )
+        if ( data + 4 > file_end )
+        {
+            printf( "Atlas Load Error: %s is truncated.\n", filename );
+            return false;
+        }
+        page_widths[ page ] = read_u16( &data[ 0 ] );
+        page_heights[ page ] = read_u16( &data[ 2 ] );
+        const size_t page_size = ( size_t )( page_widths[ page ] * page_heights[ page ] );
+        if ( data + 4 + page_size > file_end )
         {
-            int buffer_index = color * CHANNELS_PER_COLOR + channel;
-            palette_colors[ color ][ channel ] = ( float )( palette_buffer[ buffer_index ] ) / 255.0f;
+            printf( "Atlas Load Error: %s is truncated.\n", filename );
+            return false;
         }
+        data += 4 + page_size;
     }
-}
\ No newline at end of file
+
+    int number_of_tiles = 0;
+    for ( int sprite = 0; sprite < number_of_sprites; ++sprite )
+    {
+        if ( data + 1 > file_end || data + 1 + data[ 0 ] + ATLAS_SPRITE_SIZE > file_end )
+        {
+            printf( "Atlas Load Error: %s is truncated.\n", filename );
+            return false;
+        }
+        const int name_length = data[ 0 ];
+        const std::string sprite_name( ( const char* )( &data[ 1 ] ), name_length );
+        data += 1 + name_length;
+        const int page = read_u16( &data[ 0 ] );
+        if ( page >= number_of_pages )
+        {
+            printf( "Atlas Load Error: %s’s sprite %s is on page %d o’ %d.\n", filename, sprite_name.c_str(), page, number_of_pages );
+            return false;
+        }
+        const int width = read_u16( &data[ 14 ] );
+        const int height = read_u16( &data[ 16 ] );
+        const int tile_size = read_u16( &data[ 18 ] );
+        if ( tile_size == 0 && ( read_u16( &data[ 2 ] ) + read_u16( &data[ 6 ] ) > page_widths[ page ] || read_u16( &data[ 4 ] ) + read_u16( &data[ 8 ] ) > page_heights[ page ] ) )
+        {
+            printf( "Atlas Load Error: %s’s sprite %s runs off page %d.\n", filename, sprite_name.c_str(), page );
+            return false;
+        }
+        data += ATLAS_SPRITE_SIZE;
+
+        if ( tile_size > 0 )
+        {
+            const int columns = ( width + tile_size - 1 ) / tile_size;
+            const int sprite_tiles = columns * ( ( height + tile_size - 1 ) / tile_size );
+            if ( data + ( size_t )( sprite_tiles ) * ATLAS_TILE_SIZE > file_end )
+            {
+                printf( "Atlas Load Error: %s is truncated.\n", filename );
+                return false;
+            }
+            for ( int tile = 0; tile < sprite_tiles; ++tile )
+            {
+                const int tile_page = read_u16( &data[ 0 ] );
+                if ( tile_page != ATLAS_EMPTY_TILE && tile_page >= number_of_pages )
+                {
+                    printf( "Atlas Load Error: %s’s tileset %s has a tile on page %d o’ %d.\n", filename, sprite_name.c_str(), tile_page, number_of_pages );
+                    return false;
+                }
+
+                // Tiles in the last column & row only hold what’s left o’ the sprite.
+                const int tile_width = std::min( tile_size, width - ( tile % columns ) * tile_size );
+                const int tile_height = std::min( tile_size, height - ( tile / columns ) * tile_size );
+                if ( tile_page != ATLAS_EMPTY_TILE && ( read_u16( &data[ 2 ] ) + tile_width > page_widths[ tile_page ] || read_u16( &data[ 4 ] ) + tile_height > page_heights[ tile_page ] ) )
+                {
+                    printf( "Atlas Load Error: %s’s tileset %s has tile %d running off page %d.\n", filename, sprite_name.c_str(), tile, tile_page );
+                    return false;
+                }
+                data += ATLAS_TILE_SIZE;
+            }
+            number_of_tiles += sprite_tiles;
+        }
+    }
+
+    if ( number_of_atlas_tiles + number_of_tiles > MAX_ATLAS_TILES )
+    {
+        printf( "Not ’nough room for atlas %s’s %d tiles.\n", filename, number_of_tiles );
+        return false;
+    }
+    return true;
+}
+
+// Palette indices go up as a single red channel; the sprite shader looks them up in the palette.
+static unsigned int render_create_texture( int width, int height, const unsigned char* indices )
+{
+    const double upload_start = glfwGetTime();
+    unsigned int texture_id;
+    glGenTextures( 1, &texture_id );
+    glActiveTexture( GL_TEXTURE1 );
+    glBindTexture( GL_TEXTURE_2D, texture_id );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, indices );
+    bound_sprite_texture = texture_id;
+    texture_gpu_bytes += ( size_t )( width * height );
+    render_stats_total.texture_bytes_uploaded += ( size_t )( width * height );
+    render_load_stats.upload_ms += ( glfwGetTime() - upload_start ) * 1000.0;
+    return texture_id;
+}
+
+static unsigned char* render_copy_indices( const unsigned char* indices, size_t count )
+{
+    unsigned char* buffer = ( unsigned char* )( malloc( count ) );
+    memcpy( buffer, indices, count );
+    texture_cpu_bytes_kept += count;
+    return buffer;
+}
+
+static int read_u16( const unsigned char* data )
+{
+    return ( ( unsigned int )( data[ 0 ] ) << 8 ) | data[ 1 ];
+}
@@ -0,0 +1,637 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "glad.h"
+#include "glfw3.h"
+#include "shader.hpp"
+
+// Program binaries are core from GL 4.1 & ARB_get_program_binary, neither o’ which our 3.3 loader covers.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#define MAX_SHADER_PROGRAMS 64
+#define MAX_SHADER_UNIFORMS 16
+#define MAX_SHADER_ATTRIBUTES 8
+#define MAX_SHADER_UNIFORM_BLOCKS 4
+#define MAX_SHADER_NAME 64
+#define MAX_UNIFORM_VALUE_WORDS 16
+#define SHADER_CACHE_FILENAME_SIZE 64
+#define SHADER_CACHE_HEADER_SIZE 8
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+typedef void ( APIENTRYP ShaderGetProgramBinaryFunction )( GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* format, void* binary );
+typedef void ( APIENTRYP ShaderProgramBinaryFunction )( GLuint program, GLenum format, const void* binary, GLsizei length );
+typedef void ( APIENTRYP ShaderProgramParameteriFunction )( GLuint program, GLenum name, GLint value );
+typedef void ( APIENTRYP ShaderMaxCompilerThreadsFunction )( GLuint count );
+
+// value holds the raw bits o’ the last write, so any uniform type compares the same way.
+struct ShaderUniform
+{
+    uint32_t name;
+    int location;
+    unsigned int type;
+    bool written;
+    uint32_t value[ MAX_UNIFORM_VALUE_WORDS ];
+};
+
+struct ShaderAttribute
+{
+    uint32_t name;
+    int location;
+};
+
+struct ShaderUniformBlock
+{
+    uint32_t name;
+    int index;
+};
+
+// Programs are linked without waiting; everything that needs the result waits till shader_finish_program.
+struct ShaderProgram
+{
+    unsigned int id;
+    unsigned int vertex_shader;
+    unsigned int fragment_shader;
+    uint64_t key;
+    bool finished;
+    bool linked;
+    int number_of_uniforms;
+    int number_of_attributes;
+    int number_of_uniform_blocks;
+    ShaderUniform uniforms[ MAX_SHADER_UNIFORMS ];
+    ShaderAttribute attributes[ MAX_SHADER_ATTRIBUTES ];
+    ShaderUniformBlock uniform_blocks[ MAX_SHADER_UNIFORM_BLOCKS ];
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static ShaderProgram* shader_find_program( unsigned int program );
+static ShaderProgram* shader_find_finished_program( unsigned int program );
+static void shader_reflect( ShaderProgram& program );
+static uint32_t shader_hash_active_name( char* name );
+static ShaderUniform* shader_find_uniform( unsigned int program, uint32_t name );
+static bool shader_uniform_changed( ShaderUniform& uniform, const void* value, size_t size );
+static unsigned int shader_compile( unsigned int type, const char* source );
+static const char* shader_get_type_text( unsigned int type );
+static void shader_print_compile_errors( unsigned int shader, unsigned int type );
+static void shader_print_link_errors( unsigned int program );
+static uint64_t shader_hash( uint64_t hash, const char* text );
+static void shader_get_cache_filename( uint64_t key, char* filename );
+static unsigned int shader_load_cached_program( uint64_t key );
+static void shader_save_cached_program( uint64_t key, unsigned int program );
+static uint32_t read_u32( const unsigned char* data );
+static void write_u32( unsigned char* data, uint32_t value );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static const unsigned char shader_cache_signature[ 4 ] = { 'J', 'W', 'S', 0x01 };
+
+static ShaderGetProgramBinaryFunction shader_get_program_binary = nullptr;
+static ShaderProgramBinaryFunction shader_program_binary = nullptr;
+static ShaderProgramParameteriFunction shader_program_parameteri = nullptr;
+static ShaderMaxCompilerThreadsFunction shader_max_compiler_threads = nullptr;
+static bool shader_binaries_supported = false;
+static bool shader_parallel_compile_supported = false;
+
+static ShaderProgram shader_programs[ MAX_SHADER_PROGRAMS ];
+static int number_of_shader_programs = 0;
+static ShaderProgram* last_found_program = nullptr;
+static unsigned int current_program = 0;
+
+// Binaries are only good for the driver that made them, so the driver’s strings go into every key.
+static uint64_t shader_driver_hash = FNV_OFFSET_BASIS;
+
+static int shader_programs_cached = 0;
+static int shader_programs_compiled = 0;
+static int shader_cache_misses = 0;
+static double shader_submit_seconds = 0.0;
+static double shader_wait_seconds = 0.0;
+static ShaderStats shader_stats = {};
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void shader_init()
+{
+    shader_driver_hash = FNV_OFFSET_BASIS;
+    const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for ( GLenum name : driver_strings )
+    {
+        const char* text = ( const char* )( glGetString( name ) );
+        shader_driver_hash = shader_hash( shader_driver_hash, ( text ) ? text : "" );
+    }
+
+    // With parallel compiles, glLinkProgram just queues work for driver threads, & completion can be polled.
+    const char* parallel_function_name =
+        ( glfwExtensionSupported( "GL_KHR_parallel_shader_compile" ) ) ? "glMaxShaderCompilerThreadsKHR"
+        : ( glfwExtensionSupported( "GL_ARB_parallel_shader_compile" ) ) ? "glMaxShaderCompilerThreadsARB"
+        : nullptr;
+    if ( parallel_function_name )
+    {
+        shader_max_compiler_threads = ( ShaderMaxCompilerThreadsFunction )( glfwGetProcAddress( parallel_function_name ) );
+        shader_parallel_compile_supported = shader_max_compiler_threads != nullptr;
+        if ( shader_parallel_compile_supported )
+        {
+            shader_max_compiler_threads( 0xFFFFFFFF );
+        }
+    }
+
+    if ( !glfwExtensionSupported( "GL_ARB_get_program_binary" ) )
+    {
+        return;
+    }
+    shader_get_program_binary = ( ShaderGetProgramBinaryFunction )( glfwGetProcAddress( "glGetProgramBinary" ) );
+    shader_program_binary = ( ShaderProgramBinaryFunction )( glfwGetProcAddress( "glProgramBinary" ) );
+    shader_program_parameteri = ( ShaderProgramParameteriFunction )( glfwGetProcAddress( "glProgramParameteri" ) );
+
+    // Some drivers expose the functions but no formats, which means they can’t actually save anything.
+    int number_of_formats = 0;
+    glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &number_of_formats );
+    shader_binaries_supported = shader_get_program_binary && shader_program_binary && shader_program_parameteri && number_of_formats > 0;
+}
+
+unsigned int shader_create_program( const char* vertex_shader_code, const char* fragment_shader_code )
+{
+    if ( number_of_shader_programs == MAX_SHADER_PROGRAMS )
+    {
+        printf( "Too many shader programs; max is %d.\n", MAX_SHADER_PROGRAMS );
+        return 0;
+    }
+
+    const double start_time = glfwGetTime();
+    ShaderProgram& program = shader_programs[ number_of_shader_programs++ ];
+    memset( &program, 0, sizeof( program ) );
+    program.key = shader_hash( shader_hash( shader_hash( shader_driver_hash, vertex_shader_code ), "\n//\n" ), fragment_shader_code );
+
+    if ( shader_binaries_supported )
+    {
+        program.id = shader_load_cached_program( program.key );
+        if ( program.id != 0 )
+        {
+            program.finished = true;
+            program.linked = true;
+            shader_reflect( program );
+            ++shader_programs_cached;
+            shader_submit_seconds += glfwGetTime() - start_time;
+            return program.id;
+        }
+        ++shader_cache_misses;
+    }
+
+    // No status queries here: asking whether a compile worked waits for it, which would serialise every program.
+    program.id = glCreateProgram();
+    program.vertex_shader = shader_compile( GL_VERTEX_SHADER, vertex_shader_code );
+    program.fragment_shader = shader_compile( GL_FRAGMENT_SHADER, fragment_shader_code );
+    glAttachShader( program.id, program.vertex_shader );
+    glAttachShader( program.id, program.fragment_shader );
+    if ( shader_binaries_supported )
+    {
+        shader_program_parameteri( program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+    }
+    glLinkProgram( program.id );
+    ++shader_programs_compiled;
+    shader_submit_seconds += glfwGetTime() - start_time;
+    return program.id;
+}
+
+bool shader_program_ready( unsigned int program )
+{
+    const ShaderProgram* data = shader_find_program( program );
+    if ( !data || data->finished || !shader_parallel_compile_supported )
+    {
+        return true;
+    }
+    int complete = GL_FALSE;
+    glGetProgramiv( program, GL_COMPLETION_STATUS_KHR, &complete );
+    return complete == GL_TRUE;
+}
+
+bool shader_finish_program( unsigned int program )
+{
+    ShaderProgram* data = shader_find_program( program );
+    if ( !data )
+    {
+        return false;
+    }
+    if ( data->finished )
+    {
+        return data->linked;
+    }
+
+    const double start_time = glfwGetTime();
+    int result;
+    glGetProgramiv( data->id, GL_LINK_STATUS, &result );
+    data->linked = result == GL_TRUE;
+    if ( data->linked )
+    {
+        shader_reflect( *data );
+        if ( shader_binaries_supported )
+        {
+            shader_save_cached_program( data->key, data->id );
+        }
+    }
+    else
+    {
+        shader_print_compile_errors( data->vertex_shader, GL_VERTEX_SHADER );
+        shader_print_compile_errors( data->fragment_shader, GL_FRAGMENT_SHADER );
+        shader_print_link_errors( data->id );
+    }
+    glDeleteShader( data->vertex_shader );
+    glDeleteShader( data->fragment_shader );
+    data->finished = true;
+    shader_wait_seconds += glfwGetTime() - start_time;
+    return data->linked;
+}
+
+int shader_get_uniform_location( unsigned int program, uint32_t name )
+{
+    const ShaderUniform* uniform = shader_find_uniform( program, name );
+    return ( uniform ) ? uniform->location : -1;
+}
+
+int shader_get_attribute_location( unsigned int program, uint32_t name )
+{
+    const ShaderProgram* data = shader_find_finished_program( program );
+    for ( int i = 0; data && i < data->number_of_attributes; ++i )
+    {
+        if ( data->attributes[ i ].name == name )
+        {
+            return data->attributes[ i ].location;
+        }
+    }
+    return -1;
+}
+
+int shader_get_uniform_block_index( unsigned int program, uint32_t name )
+{
+    const ShaderProgram* data = shader_find_finished_program( program );
+    for ( int i = 0; data && i < data->number_of_uniform_blocks; ++i )
+    {
+        if ( data->uniform_blocks[ i ].name == name )
+        {
+            return data->uniform_blocks[ i ].index;
+        }
+    }
+    return -1;
+}
+
+void shader_use_program( unsigned int program )
+{
+    if ( program != current_program )
+    {
+        glUseProgram( program );
+        current_program = program;
+        ++shader_stats.program_binds;
+    }
+    else
+    {
+        ++shader_stats.program_binds_skipped;
+    }
+}
+
+void shader_set_int( unsigned int program, uint32_t name, int value )
+{
+    ShaderUniform* uniform = shader_find_uniform( program, name );
+    if ( uniform && shader_uniform_changed( *uniform, &value, sizeof( value ) ) )
+    {
+        shader_use_program( program );
+        glUniform1i( uniform->location, value );
+    }
+}
+
+void shader_set_float( unsigned int program, uint32_t name, float value )
+{
+    ShaderUniform* uniform = shader_find_uniform( program, name );
+    if ( uniform && shader_uniform_changed( *uniform, &value, sizeof( value ) ) )
+    {
+        shader_use_program( program );
+        glUniform1f( uniform->location, value );
+    }
+}
+
+void shader_set_vec4( unsigned int program, uint32_t name, float x, float y, float z, float w )
+{
+    const float value[ 4 ] = { x, y, z, w };
+    ShaderUniform* uniform = shader_find_uniform( program, name );
+    if ( uniform && shader_uniform_changed( *uniform, value, sizeof( value ) ) )
+    {
+        shader_use_program( program );
+        glUniform4fv( uniform->location, 1, value );
+    }
+}
+
+void shader_set_mat4( unsigned int program, uint32_t name, const float* value )
+{
+    ShaderUniform* uniform = shader_find_uniform( program, name );
+    if ( uniform && shader_uniform_changed( *uniform, value, sizeof( float ) * 16 ) )
+    {
+        shader_use_program( program );
+        glUniformMatrix4fv( uniform->location, 1, GL_FALSE, value );
+    }
+}
+
+ShaderStats shader_get_stats()
+{
+    return shader_stats;
+}
+
+bool shader_can_compile_in_parallel()
+{
+    return shader_parallel_compile_supported;
+}
+
+void shader_print_report()
+{
+    printf
+    (
+        "Shaders: %d programs loaded from cache & %d compiled, %d cache misses%s; %.2f ms submitting, %.2f ms waiting%s.\n",
+        shader_programs_cached,
+        shader_programs_compiled,
+        shader_cache_misses,
+        ( shader_binaries_supported ) ? "" : " (program binaries unsupported)",
+        shader_submit_seconds * 1000.0,
+        shader_wait_seconds * 1000.0,
+        ( shader_parallel_compile_supported ) ? " (parallel compile)" : ""
+    );
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static ShaderProgram* shader_find_program( unsigned int program )
+{
+    for ( int i = 0; i < number_of_shader_programs; ++i )
+    {
+        if ( shader_programs[ i ].id == program )
+        {
+            return &shader_programs[ i ];
+        }
+    }
+    return nullptr;
+}
+
+// Uniforms are set far more often than programs are made, so the last program found is checked first.
+static ShaderProgram* shader_find_finished_program( unsigned int program )
+{
+    if ( !last_found_program || last_found_program->id != program )
+    {
+        last_found_program = shader_find_program( program );
+    }
+    return ( last_found_program && last_found_program->linked ) ? last_found_program : nullptr;
+}
+
+static void shader_reflect( ShaderProgram& program )
+{
+    char name[ MAX_SHADER_NAME ];
+    int count = 0;
+    glGetProgramiv( program.id, GL_ACTIVE_UNIFORMS, &count );
+    for ( int i = 0; i < count; ++i )
+    {
+        int size;
+        GLenum type;
+        glGetActiveUniform( program.id, i, MAX_SHADER_NAME, nullptr, &size, &type, name );
+        const int location = glGetUniformLocation( program.id, name );
+        if ( location == -1 ) // Uniforms inside blocks have no location & are set through their buffer.
+        {
+            continue;
+        }
+        if ( program.number_of_uniforms == MAX_SHADER_UNIFORMS )
+        {
+            printf( "Shader program %u has too many uniforms; max is %d.\n", program.id, MAX_SHADER_UNIFORMS );
+            break;
+        }
+        ShaderUniform& uniform = program.uniforms[ program.number_of_uniforms++ ];
+        uniform.name = shader_hash_active_name( name );
+        uniform.location = location;
+        uniform.type = type;
+        uniform.written = false;
+    }
+
+    glGetProgramiv( program.id, GL_ACTIVE_ATTRIBUTES, &count );
+    for ( int i = 0; i < count && program.number_of_attributes < MAX_SHADER_ATTRIBUTES; ++i )
+    {
+        int size;
+        GLenum type;
+        glGetActiveAttrib( program.id, i, MAX_SHADER_NAME, nullptr, &size, &type, name );
+        program.attributes[ program.number_of_attributes++ ] = { shader_hash_active_name( name ), glGetAttribLocation( program.id, name ) };
+    }
+
+    glGetProgramiv( program.id, GL_ACTIVE_UNIFORM_BLOCKS, &count );
+    for ( int i = 0; i < count && program.number_of_uniform_blocks < MAX_SHADER_UNIFORM_BLOCKS; ++i )
+    {
+        glGetActiveUniformBlockName( program.id, i, MAX_SHADER_NAME, nullptr, name );
+        program.uniform_blocks[ program.number_of_uniform_blocks++ ] = { shader_hash_active_name( name ), i };
+    }
+}
+
+// GL names arrays by their first element, “u_Colors[0]”, but they’re looked up by their plain name.
+static uint32_t shader_hash_active_name( char* name )
+{
+    char* bracket = strchr( name, '[' );
+    if ( bracket )
+    {
+        *bracket = '\0';
+    }
+    return shader_hash_name( name );
+}
+
+static ShaderUniform* shader_find_uniform( unsigned int program, uint32_t name )
+{
+    ShaderProgram* data = shader_find_finished_program( program );
+    for ( int i = 0; data && i < data->number_of_uniforms; ++i )
+    {
+        if ( data->uniforms[ i ].name == name )
+        {
+            return &data->uniforms[ i ];
+        }
+    }
+    return nullptr;
+}
+
+static bool shader_uniform_changed( ShaderUniform& uniform, const void* value, size_t size )
+{
+    if ( uniform.written && memcmp( uniform.value, value, size ) == 0 )
+    {
+        ++shader_stats.uniform_writes_skipped;
+        return false;
+    }
+    memcpy( uniform.value, value, size );
+    uniform.written = true;
+    ++shader_stats.uniform_writes;
+    shader_stats.uniform_bytes += size;
+    return true;
+}
+
+static unsigned int shader_compile( unsigned int type, const char* source )
+{
+    unsigned int id = glCreateShader( type );
+    glShaderSource( id, 1, &source, nullptr );
+    glCompileShader( id );
+    return id;
+}
+
+static const char* shader_get_type_text( unsigned int type )
+{
+    return ( type == GL_VERTEX_SHADER )
+        ? "vertex"
+        : "fragment";
+}
+
+static void shader_print_compile_errors( unsigned int shader, unsigned int type )
+{
+    int result;
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &result );
+    if ( result == GL_FALSE )
+    {
+        int message_length;
+        glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &message_length );
+        char* message = ( char* )( alloca( ( message_length + 1 ) * sizeof( char ) ) );
+        message[ 0 ] = '\0';
+        glGetShaderInfoLog( shader, message_length, &message_length, message );
+        printf( "Failed to compile %s shader: %s\n", shader_get_type_text( type ), message );
+    }
+}
+
+static void shader_print_link_errors( unsigned int program )
+{
+    int message_length;
+    glGetProgramiv( program, GL_INFO_LOG_LENGTH, &message_length );
+    char* message = ( char* )( alloca( ( message_length + 1 ) * sizeof( char ) ) );
+    message[ 0 ] = '\0';
+    glGetProgramInfoLog( program, message_length, &message_length, message );
+    printf( "Failed to link shader program: %s\n", message );
+}
+
+// 64-bit FNV-1a.
+static uint64_t shader_hash( uint64_t hash, const char* text )
+{
+    for ( const unsigned char* c = ( const unsigned char* )( text ); *c != '\0'; ++c )
+    {
+        hash = ( hash ^ *c ) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static void shader_get_cache_filename( uint64_t key, char* filename )
+{
+    snprintf( filename, SHADER_CACHE_FILENAME_SIZE, "bin/shader-cache-%016llx.jwsb", ( unsigned long long )( key ) );
+}
+
+// Cache files are the signature, the binary format as a big-endian u32, then the driver’s binary as-is.
+static unsigned int shader_load_cached_program( uint64_t key )
+{
+    char filename[ SHADER_CACHE_FILENAME_SIZE ];
+    shader_get_cache_filename( key, filename );
+    FILE* file = fopen( filename, "rb" );
+    if ( !file )
+    {
+        return 0;
+    }
+
+    fseek( file, 0, SEEK_END );
+    const long file_size = ftell( file );
+    rewind( file );
+    if ( file_size <= SHADER_CACHE_HEADER_SIZE )
+    {
+        fclose( file );
+        return 0;
+    }
+
+    unsigned char* file_buffer = ( unsigned char* )( malloc( file_size ) );
+    const bool read_whole_file = file_buffer && ( long )( fread( file_buffer, 1, file_size, file ) ) == file_size;
+    fclose( file );
+    if ( !read_whole_file || memcmp( file_buffer, shader_cache_signature, sizeof( shader_cache_signature ) ) != 0 )
+    {
+        free( file_buffer );
+        return 0;
+    }
+
+    // A driver update can reject a binary even with matching strings, so failing to link here just means recompiling.
+    unsigned int program = glCreateProgram();
+    shader_program_binary( program, read_u32( &file_buffer[ 4 ] ), &file_buffer[ SHADER_CACHE_HEADER_SIZE ], file_size - SHADER_CACHE_HEADER_SIZE );
+    free( file_buffer );
+    int result;
+    glGetProgramiv( program, GL_LINK_STATUS, &result );
+    if ( result == GL_FALSE )
+    {
+        glDeleteProgram( program );
+        return 0;
+    }
+    return program;
+}
+
+static void shader_save_cached_program( uint64_t key, unsigned int program )
+{
+    int binary_length = 0;
+    glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &binary_length );
+    if ( binary_length <= 0 )
+    {
+        return;
+    }
+
+    unsigned char* file_buffer = ( unsigned char* )( malloc( SHADER_CACHE_HEADER_SIZE + binary_length ) );
+    if ( !file_buffer )
+    {
+        return;
+    }
+    GLenum format = 0;
+    shader_get_program_binary( program, binary_length, &binary_length, &format, &file_buffer[ SHADER_CACHE_HEADER_SIZE ] );
+    memcpy( file_buffer, shader_cache_signature, sizeof( shader_cache_signature ) );
+    write_u32( &file_buffer[ 4 ], format );
+
+    char filename[ SHADER_CACHE_FILENAME_SIZE ];
+    shader_get_cache_filename( key, filename );
+    FILE* file = fopen( filename, "wb" );
+    if ( !file )
+    {
+        printf( "Couldn’t write shader cache file %s\n", filename );
+        free( file_buffer );
+        return;
+    }
+    fwrite( file_buffer, 1, SHADER_CACHE_HEADER_SIZE + binary_length, file );
+    fclose( file );
+    free( file_buffer );
+}
+
+static uint32_t read_u32( const unsigned char* data )
+{
+    return ( ( uint32_t )( data[ 0 ] ) << 24 ) | ( ( uint32_t )( data[ 1 ] ) << 16 ) | ( ( uint32_t )( data[ 2 ] ) << 8 ) | data[ 3 ];
+}
+
+static void write_u32( unsigned char* data, uint32_t value )
+{
+    data[ 0 ] = ( unsigned char )( value >> 24 );
+    data[ 1 ] = ( unsigned char )( value >> 16 );
+    data[ 2 ] = ( unsigned char )( value >> 8 );
+    data[ 3 ] = ( unsigned char )( value );
+}
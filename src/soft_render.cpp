@@ -0,0 +1,558 @@
+#include "config.hpp"
+#include "soft_render.hpp"
+
+#if CONFIG_SOFTWARE_RENDERER
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "palette.hpp"
+#include "profiler.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define SOFT_RENDER_WIDTH CONFIG_WINDOW_WIDTH_PIXELS
+#define SOFT_RENDER_HEIGHT CONFIG_WINDOW_HEIGHT_PIXELS
+#define SOFT_TILE_WIDTH 80
+#define SOFT_TILE_HEIGHT 32
+#define SOFT_TILE_COLUMNS ( ( SOFT_RENDER_WIDTH + SOFT_TILE_WIDTH - 1 ) / SOFT_TILE_WIDTH )
+#define SOFT_TILE_ROWS ( ( SOFT_RENDER_HEIGHT + SOFT_TILE_HEIGHT - 1 ) / SOFT_TILE_HEIGHT )
+#define SOFT_TILE_COUNT ( SOFT_TILE_COLUMNS * SOFT_TILE_ROWS )
+#define MAX_SOFT_COMMANDS 8192
+#define MAX_SOFT_RENDER_THREADS 16
+#define MAX_SPAN_HIDDEN_INDICES 4
+#define FULL_ALPHA_THRESHOLD 128
+#define NEVER_VISIBLE 256
+#define TEXEL_SNAP 256.0
+
+// A queued draw, with everything that doesn’t depend on the tile worked out up front. Rects have no indices.
+// Sprites find their texel through s & t, how far ’cross & down the quad a pixel centre is, each running 0 to 1.
+// Where the sprite starts on its page is kept as whole texels (u_texel, v_texel) plus what’s left o’ one.
+struct SoftCommand
+{
+    int left;
+    int top;
+    int right;
+    int bottom;
+    const unsigned char* indices;
+    int page_width;
+    int page_height;
+    int color;
+    int palette_row;
+    int palette_offset;
+    int alpha_threshold;
+    bool axis_aligned;
+
+    // Final indices that don’t pass the alpha test in the sprite’s own palette row, so spans can be tested
+    // 16 pixels at a time; -1 if there are too many to check that way.
+    int number_of_hidden;
+    unsigned char hidden[ MAX_SPAN_HIDDEN_INDICES ];
+
+    double origin_x;
+    double origin_y;
+    double s_x;
+    double s_y;
+    double t_x;
+    double t_y;
+    int u_texel;
+    int v_texel;
+    double u_origin;
+    double u_span;
+    double v_origin;
+    double v_span;
+};
+
+struct SoftScanline
+{
+    int palette_row;
+    float x;
+    float y;
+    float a;
+    float b;
+    float c;
+    float d;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static void soft_render_queue( const SoftCommand& command );
+static void soft_render_flush();
+static void soft_render_work();
+static void soft_render_draw_tiles();
+static void soft_render_draw_tile( int tile );
+static void soft_render_draw_axis_aligned( const SoftCommand& command, int left, int top, int right, int bottom );
+static void soft_render_draw_quad( const SoftCommand& command, int left, int top, int right, int bottom );
+static void soft_render_draw_span( const SoftCommand& command, int line, unsigned char* dest, const unsigned char* source, int count );
+static int soft_render_get_alpha_threshold( float alpha );
+static double soft_render_snap_texels( double texels );
+static int soft_render_get_texel( int texel, double position, double span, int size );
+static void soft_render_clip( double left, double top, double right, double bottom, SoftCommand& command );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+alignas( 16 ) static unsigned char soft_framebuffer[ SOFT_RENDER_HEIGHT ][ SOFT_RENDER_WIDTH ];
+static unsigned char soft_presented[ SOFT_RENDER_HEIGHT ][ SOFT_RENDER_WIDTH ];
+static unsigned char soft_palette_alphas[ PALETTE_ROWS ][ PALETTE_COLORS ];
+static SoftScanline soft_scanlines[ SOFT_RENDER_HEIGHT ];
+static SoftCommand soft_commands[ MAX_SOFT_COMMANDS ];
+static int number_of_soft_commands = 0;
+
+// Workers sleep till the generation changes, then take tiles till there are none left. The last tile to
+// finish wakes the thread that asked for the frame.
+static std::thread soft_workers[ MAX_SOFT_RENDER_THREADS ];
+static int number_of_soft_workers = 0;
+static std::mutex soft_mutex;
+static std::condition_variable soft_work_ready;
+static std::condition_variable soft_work_done;
+static int soft_generation = 0;
+static int soft_tiles_finished = SOFT_TILE_COUNT;
+static bool soft_quitting = false;
+static std::atomic<int> soft_next_tile( SOFT_TILE_COUNT );
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+void soft_render_init( int threads )
+{
+    if ( threads <= 0 )
+    {
+        threads = std::max( ( int )( std::thread::hardware_concurrency() ), 1 );
+    }
+
+    // The thread that presents draws tiles too, so it only needs helpers for the rest.
+    number_of_soft_workers = std::min( threads, MAX_SOFT_RENDER_THREADS ) - 1;
+    for ( int worker = 0; worker < number_of_soft_workers; ++worker )
+    {
+        soft_workers[ worker ] = std::thread( soft_render_work );
+    }
+    for ( int line = 0; line < SOFT_RENDER_HEIGHT; ++line )
+    {
+        soft_render_set_scanline( line, -1, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f );
+    }
+}
+
+void soft_render_close()
+{
+    {
+        std::lock_guard<std::mutex> lock( soft_mutex );
+        soft_quitting = true;
+    }
+    soft_work_ready.notify_all();
+    for ( int worker = 0; worker < number_of_soft_workers; ++worker )
+    {
+        soft_workers[ worker ].join();
+    }
+    number_of_soft_workers = 0;
+}
+
+void soft_render_start()
+{
+    for ( int row = 0; row < PALETTE_ROWS; ++row )
+    {
+        const unsigned char* colors = palette_get_color( row, 0 );
+        for ( int index = 0; index < PALETTE_COLORS; ++index )
+        {
+            soft_palette_alphas[ row ][ index ] = colors[ index * CHANNELS_PER_COLOR + 3 ];
+        }
+    }
+}
+
+void soft_render_sprite( const SoftRenderPage& page, const SoftRenderCorner* corners, float alpha, int palette_row, int palette_offset )
+{
+    const int alpha_threshold = soft_render_get_alpha_threshold( alpha );
+    double x[ 4 ];
+    double y[ 4 ];
+    for ( int corner = 0; corner < 4; ++corner )
+    {
+        x[ corner ] = corners[ corner ].x;
+        y[ corner ] = corners[ corner ].y;
+    }
+    const double edge_x[ 2 ] = { x[ 1 ] - x[ 0 ], x[ 3 ] - x[ 0 ] };
+    const double edge_y[ 2 ] = { y[ 1 ] - y[ 0 ], y[ 3 ] - y[ 0 ] };
+    const double area = edge_x[ 0 ] * edge_y[ 1 ] - edge_y[ 0 ] * edge_x[ 1 ];
+    if ( !page.indices || alpha_threshold == NEVER_VISIBLE || area == 0.0 )
+    {
+        return;
+    }
+
+    SoftCommand command = {};
+    soft_render_clip( *std::min_element( x, x + 4 ), *std::min_element( y, y + 4 ), *std::max_element( x, x + 4 ), *std::max_element( y, y + 4 ), command );
+    if ( command.right <= command.left || command.bottom <= command.top )
+    {
+        return;
+    }
+
+    command.indices = page.indices;
+    command.page_width = page.width;
+    command.page_height = page.height;
+    command.palette_row = palette_row;
+    command.palette_offset = palette_offset;
+    command.alpha_threshold = alpha_threshold;
+    command.axis_aligned = edge_y[ 0 ] == 0.0 && edge_x[ 1 ] == 0.0 && edge_x[ 0 ] > 0.0 && edge_y[ 1 ] > 0.0;
+    command.origin_x = x[ 0 ];
+    command.origin_y = y[ 0 ];
+    command.s_x = edge_y[ 1 ] / area;
+    command.s_y = -edge_x[ 1 ] / area;
+    command.t_x = -edge_y[ 0 ] / area;
+    command.t_y = edge_x[ 0 ] / area;
+
+    // UVs come as floats divided by the page size, so they’re snapped back to texels ’fore use, & the whole texels
+    // kept out o’ the sums; otherwise a pixel centre right on a texel edge could pick a different texel depending
+    // on where on its page the sprite sits, & an atlas sprite wouldn’t draw like the same image on its own.
+    const double u_origin = soft_render_snap_texels( ( double )( corners[ 0 ].u ) * page.width );
+    const double v_origin = soft_render_snap_texels( ( double )( corners[ 0 ].v ) * page.height );
+    command.u_texel = ( int )( std::floor( u_origin ) );
+    command.v_texel = ( int )( std::floor( v_origin ) );
+    command.u_origin = u_origin - command.u_texel;
+    command.v_origin = v_origin - command.v_texel;
+    command.u_span = soft_render_snap_texels( ( ( double )( corners[ 1 ].u ) - corners[ 0 ].u ) * page.width );
+    command.v_span = soft_render_snap_texels( ( ( double )( corners[ 3 ].v ) - corners[ 0 ].v ) * page.height );
+
+    // Indices below the bank offset can’t come out o’ the add, so they needn’t be checked.
+    command.number_of_hidden = 0;
+    for ( int index = palette_offset; index < PALETTE_COLORS; ++index )
+    {
+        if ( soft_palette_alphas[ palette_row ][ index ] >= alpha_threshold )
+        {
+            continue;
+        }
+        if ( command.number_of_hidden == MAX_SPAN_HIDDEN_INDICES )
+        {
+            command.number_of_hidden = -1;
+            break;
+        }
+        command.hidden[ command.number_of_hidden++ ] = ( unsigned char )( index );
+    }
+    soft_render_queue( command );
+}
+
+void soft_render_rect( const Rect& rect, int color )
+{
+    SoftCommand command = {};
+    soft_render_clip( rect.x, rect.y, rect_right( rect ), rect_bottom( rect ), command );
+    if ( command.right <= command.left || command.bottom <= command.top )
+    {
+        return;
+    }
+    command.indices = nullptr;
+    command.color = color;
+    soft_render_queue( command );
+}
+
+void soft_render_present()
+{
+    soft_render_flush();
+    memcpy( soft_presented, soft_framebuffer, sizeof( soft_presented ) );
+}
+
+void soft_render_set_scanline( int line, int palette_row, float x, float y, float a, float b, float c, float d )
+{
+    soft_scanlines[ line ] = { palette_row, x, y, a, b, c, d };
+}
+
+const unsigned char* soft_render_get_indices()
+{
+    return &soft_presented[ 0 ][ 0 ];
+}
+
+void soft_render_resolve( unsigned char* rgb, int palette_row, const unsigned char* background )
+{
+    const float center_x = SOFT_RENDER_WIDTH * 0.5f;
+    const float center_y = SOFT_RENDER_HEIGHT * 0.5f;
+    for ( int y = 0; y < SOFT_RENDER_HEIGHT; ++y )
+    {
+        const SoftScanline& line = soft_scanlines[ y ];
+        const int row = ( line.palette_row >= 0 ) ? line.palette_row : palette_row;
+        for ( int x = 0; x < SOFT_RENDER_WIDTH; ++x )
+        {
+            const float dx = x + 0.5f - center_x;
+            const float dy = y + 0.5f - center_y;
+            const int source_x = ( int )( std::floor( line.a * dx + line.b * dy + center_x + line.x ) );
+            const int source_y = ( int )( std::floor( line.c * dx + line.d * dy + center_y + line.y ) );
+            const int index = soft_presented[ ( ( source_y % SOFT_RENDER_HEIGHT ) + SOFT_RENDER_HEIGHT ) % SOFT_RENDER_HEIGHT ][ ( ( source_x % SOFT_RENDER_WIDTH ) + SOFT_RENDER_WIDTH ) % SOFT_RENDER_WIDTH ];
+            memcpy( rgb, ( index == 0 ) ? background : palette_get_color( row, index ), 3 );
+            rgb += 3;
+        }
+    }
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static void soft_render_queue( const SoftCommand& command )
+{
+    if ( number_of_soft_commands == MAX_SOFT_COMMANDS )
+    {
+        soft_render_flush();
+    }
+    soft_commands[ number_of_soft_commands++ ] = command;
+}
+
+static void soft_render_flush()
+{
+    PROFILE_ZONE( "soft_render_flush" );
+    if ( number_of_soft_commands == 0 )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( soft_mutex );
+        soft_tiles_finished = 0;
+        soft_next_tile = 0;
+        ++soft_generation;
+    }
+    soft_work_ready.notify_all();
+    soft_render_draw_tiles();
+
+    std::unique_lock<std::mutex> lock( soft_mutex );
+    soft_work_done.wait( lock, []{ return soft_tiles_finished == SOFT_TILE_COUNT; } );
+    number_of_soft_commands = 0;
+}
+
+static void soft_render_work()
+{
+    int generation = 0;
+    for ( ;; )
+    {
+        {
+            std::unique_lock<std::mutex> lock( soft_mutex );
+            soft_work_ready.wait( lock, [ &generation ]{ return soft_quitting || soft_generation != generation; } );
+            if ( soft_quitting )
+            {
+                return;
+            }
+            generation = soft_generation;
+        }
+        soft_render_draw_tiles();
+    }
+}
+
+static void soft_render_draw_tiles()
+{
+    PROFILE_ZONE( "soft_render_draw_tiles" );
+    int finished = 0;
+    for ( int tile = soft_next_tile++; tile < SOFT_TILE_COUNT; tile = soft_next_tile++ )
+    {
+        soft_render_draw_tile( tile );
+        ++finished;
+    }
+    if ( finished > 0 )
+    {
+        std::lock_guard<std::mutex> lock( soft_mutex );
+        soft_tiles_finished += finished;
+        if ( soft_tiles_finished == SOFT_TILE_COUNT )
+        {
+            soft_work_done.notify_one();
+        }
+    }
+}
+
+// Every tile replays the whole queue, skipping what misses it, so draws within a tile keep their order.
+static void soft_render_draw_tile( int tile )
+{
+    const int tile_left = ( tile % SOFT_TILE_COLUMNS ) * SOFT_TILE_WIDTH;
+    const int tile_top = ( tile / SOFT_TILE_COLUMNS ) * SOFT_TILE_HEIGHT;
+    const int tile_right = std::min( tile_left + SOFT_TILE_WIDTH, SOFT_RENDER_WIDTH );
+    const int tile_bottom = std::min( tile_top + SOFT_TILE_HEIGHT, SOFT_RENDER_HEIGHT );
+    for ( int i = 0; i < number_of_soft_commands; ++i )
+    {
+        const SoftCommand& command = soft_commands[ i ];
+        const int left = std::max( command.left, tile_left );
+        const int top = std::max( command.top, tile_top );
+        const int right = std::min( command.right, tile_right );
+        const int bottom = std::min( command.bottom, tile_bottom );
+        if ( right <= left || bottom <= top )
+        {
+            continue;
+        }
+
+        if ( !command.indices )
+        {
+            for ( int y = top; y < bottom; ++y )
+            {
+                memset( &soft_framebuffer[ y ][ left ], command.color, right - left );
+            }
+        }
+        else if ( command.axis_aligned )
+        {
+            soft_render_draw_axis_aligned( command, left, top, right, bottom );
+        }
+        else
+        {
+            soft_render_draw_quad( command, left, top, right, bottom );
+        }
+    }
+}
+
+// An unrotated sprite covers its whole clipped box, & every row o’ it reads the same texel columns, so they’re
+// found once. Unscaled, unflipped sprites read theirs straight off the page.
+static void soft_render_draw_axis_aligned( const SoftCommand& command, int left, int top, int right, int bottom )
+{
+    const int count = right - left;
+    int columns[ SOFT_TILE_WIDTH ];
+    bool contiguous = true;
+    for ( int i = 0; i < count; ++i )
+    {
+        const double s = ( left + i + 0.5 - command.origin_x ) * command.s_x;
+        columns[ i ] = soft_render_get_texel( command.u_texel, command.u_origin + s * command.u_span, command.u_span, command.page_width );
+        contiguous = contiguous && columns[ i ] == columns[ 0 ] + i;
+    }
+
+    unsigned char gathered[ SOFT_TILE_WIDTH ];
+    for ( int y = top; y < bottom; ++y )
+    {
+        const double t = ( y + 0.5 - command.origin_y ) * command.t_y;
+        const unsigned char* source = &command.indices[ soft_render_get_texel( command.v_texel, command.v_origin + t * command.v_span, command.v_span, command.page_height ) * command.page_width ];
+        if ( contiguous )
+        {
+            source += columns[ 0 ];
+        }
+        else
+        {
+            for ( int i = 0; i < count; ++i )
+            {
+                gathered[ i ] = source[ columns[ i ] ];
+            }
+            source = gathered;
+        }
+        soft_render_draw_span( command, y, &soft_framebuffer[ y ][ left ], source, count );
+    }
+}
+
+// Rotated sprites test each pixel centre in their box against the quad. A quad is convex, so the pixels it
+// covers on a row are one unbroken run.
+static void soft_render_draw_quad( const SoftCommand& command, int left, int top, int right, int bottom )
+{
+    unsigned char gathered[ SOFT_TILE_WIDTH ];
+    for ( int y = top; y < bottom; ++y )
+    {
+        const double dy = y + 0.5 - command.origin_y;
+        int first = right;
+        int count = 0;
+        for ( int x = left; x < right; ++x )
+        {
+            const double dx = x + 0.5 - command.origin_x;
+            const double s = dx * command.s_x + dy * command.s_y;
+            const double t = dx * command.t_x + dy * command.t_y;
+            if ( s < 0.0 || s >= 1.0 || t < 0.0 || t >= 1.0 )
+            {
+                if ( count > 0 )
+                {
+                    break;
+                }
+                continue;
+            }
+            first = std::min( first, x );
+            const int column = soft_render_get_texel( command.u_texel, command.u_origin + s * command.u_span, command.u_span, command.page_width );
+            const int row = soft_render_get_texel( command.v_texel, command.v_origin + t * command.v_span, command.v_span, command.page_height );
+            gathered[ count++ ] = command.indices[ row * command.page_width + column ];
+        }
+        if ( count > 0 )
+        {
+            soft_render_draw_span( command, y, &soft_framebuffer[ y ][ first ], gathered, count );
+        }
+    }
+}
+
+// Writes index + bank offset wherever the palette colour that gives passes the alpha test. While the line uses
+// the sprite’s own palette row, its few hidden indices are compared 16 pixels at a time.
+static void soft_render_draw_span( const SoftCommand& command, int line, unsigned char* dest, const unsigned char* source, int count )
+{
+    const int row = ( soft_scanlines[ line ].palette_row >= 0 ) ? soft_scanlines[ line ].palette_row : command.palette_row;
+    int i = 0;
+#ifdef __SSE2__
+    if ( row == command.palette_row && command.number_of_hidden >= 0 )
+    {
+        const __m128i offset = _mm_set1_epi8( ( char )( command.palette_offset ) );
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            const __m128i indices = _mm_adds_epu8( _mm_loadu_si128( ( const __m128i* )( &source[ i ] ) ), offset );
+            __m128i hidden = _mm_setzero_si128();
+            for ( int index = 0; index < command.number_of_hidden; ++index )
+            {
+                hidden = _mm_or_si128( hidden, _mm_cmpeq_epi8( indices, _mm_set1_epi8( ( char )( command.hidden[ index ] ) ) ) );
+            }
+            const __m128i existing = _mm_loadu_si128( ( const __m128i* )( &dest[ i ] ) );
+            _mm_storeu_si128( ( __m128i* )( &dest[ i ] ), _mm_or_si128( _mm_and_si128( hidden, existing ), _mm_andnot_si128( hidden, indices ) ) );
+        }
+    }
+#endif
+    const unsigned char* alphas = soft_palette_alphas[ row ];
+    for ( ; i < count; ++i )
+    {
+        const int index = std::min( source[ i ] + command.palette_offset, PALETTE_COLORS - 1 );
+        if ( alphas[ index ] >= command.alpha_threshold )
+        {
+            dest[ i ] = ( unsigned char )( index );
+        }
+    }
+}
+
+// The lowest palette alpha that survives the shader’s 50% cutoff once multiplied by the sprite’s alpha,
+// worked out the same way in floats. Alpha ’bove 1 is only ever left unapplied by GL, so it counts as 1.
+static int soft_render_get_alpha_threshold( float alpha )
+{
+    if ( alpha >= 1.0f )
+    {
+        return FULL_ALPHA_THRESHOLD;
+    }
+    for ( int threshold = 0; threshold < PALETTE_COLORS; ++threshold )
+    {
+        if ( threshold / 255.0f * alpha >= 0.5f )
+        {
+            return threshold;
+        }
+    }
+    return NEVER_VISIBLE;
+}
+
+// To the nearest 1/256 o’ a texel: float UVs are off by far less on any page that fits, & no sprite’s placed finer.
+static double soft_render_snap_texels( double texels )
+{
+    return std::round( texels * TEXEL_SNAP ) / TEXEL_SNAP;
+}
+
+// Nearest sampling with clamp to edge, as the GL textures are set up; position is in texels past texel. A position
+// right on a texel edge takes the texel the span runs on into, so a sprite’s first row or column is always its own,
+// even when it’s read backwards, as rows are from bottom-first pages.
+static int soft_render_get_texel( int texel, double position, double span, int size )
+{
+    const int offset = ( span < 0.0 ) ? ( int )( std::ceil( position ) ) - 1 : ( int )( std::floor( position ) );
+    return std::min( std::max( texel + offset, 0 ), size - 1 );
+}
+
+// A pixel is covered when its centre is, counting left & top edges but not right & bottom ones.
+static void soft_render_clip( double left, double top, double right, double bottom, SoftCommand& command )
+{
+    command.left = ( int )( std::max( std::ceil( left - 0.5 ), 0.0 ) );
+    command.top = ( int )( std::max( std::ceil( top - 0.5 ), 0.0 ) );
+    command.right = ( int )( std::min( std::ceil( right - 0.5 ), ( double )( SOFT_RENDER_WIDTH ) ) );
+    command.bottom = ( int )( std::min( std::ceil( bottom - 0.5 ), ( double )( SOFT_RENDER_HEIGHT ) ) );
+}
+
+#endif
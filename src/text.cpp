@@ -0,0 +1,307 @@
+#include "config.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "render.hpp"
+#include "text.hpp"
+
+#define MAX_FONTS 8
+#define MAX_FONT_GLYPHS 256
+#define MAX_FILENAME 255
+#define FONT_HEADER_SIZE 10
+#define FONT_GLYPH_SIZE 10
+#define TEXT_CACHE_SIZE 512
+#define TEXT_CACHE_PIECES 32768
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+static_assert( ( TEXT_CACHE_SIZE & ( TEXT_CACHE_SIZE - 1 ) ) == 0, "Text cache size must be a power o’ 2." );
+
+struct FontGlyph
+{
+    Rect src;
+    int advance;
+};
+
+struct FontData
+{
+    Texture texture;
+    int line_height;
+    int first_character;
+    int number_of_glyphs;
+    FontGlyph glyphs[ MAX_FONT_GLYPHS ];
+};
+
+// A string laid out once: the pieces o’ its glyphs, in order, & the size o’ the box they fill. Keyed by a hash
+// o’ the font & text; key 0 marks an empty slot.
+struct TextLayout
+{
+    uint64_t key;
+    int first_piece;
+    int number_of_pieces;
+    int width;
+    int height;
+};
+
+
+
+//
+//  PRIVATE FUNCTION DECLARATIONS
+//
+///////////////////////////////////////////////////////////
+
+static const TextLayout* text_get_layout( Font font, const char* text );
+static void text_build_layout( const FontData& data, const char* text, TextLayout& layout );
+static void text_clear_cache();
+static unsigned char* text_read_file( const char* filename, long* file_size );
+static int read_u16( const unsigned char* data );
+
+
+
+//
+//  PRIVATE VARIABLES
+//
+///////////////////////////////////////////////////////////
+
+static FontData fonts[ MAX_FONTS ];
+static int number_of_fonts = 0;
+
+// When either table fills up, the whole cache is emptied; text drawn every frame is back in it a frame later.
+static TextLayout text_cache[ TEXT_CACHE_SIZE ];
+static int number_of_cached_layouts = 0;
+static SpritePiece cached_pieces[ TEXT_CACHE_PIECES ];
+static int number_of_cached_pieces = 0;
+
+
+
+//
+//  PUBLIC FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+Font text_load_font( const char* name )
+{
+    if ( number_of_fonts == MAX_FONTS )
+    {
+        printf( "Not ’nough room for any mo’ fonts.\n" );
+        return -1;
+    }
+
+    char full_filename[ MAX_FILENAME + 9 ] = "bin/";
+    strcat( full_filename, name );
+    strcat( full_filename, ".jwf" );
+
+    long file_size;
+    unsigned char* file_buffer = text_read_file( full_filename, &file_size );
+    if ( !file_buffer )
+    {
+        return -1;
+    }
+
+    FontData& data = fonts[ number_of_fonts ];
+    if ( file_size < FONT_HEADER_SIZE || memcmp( file_buffer, "JWF\x01", 4 ) != 0 )
+    {
+        printf( "Font Load Error: %s isn’t a font metrics file.\n", full_filename );
+        free( file_buffer );
+        return -1;
+    }
+    data.line_height = read_u16( &file_buffer[ 4 ] );
+    data.first_character = read_u16( &file_buffer[ 6 ] );
+    data.number_of_glyphs = read_u16( &file_buffer[ 8 ] );
+    if ( data.number_of_glyphs > MAX_FONT_GLYPHS || file_size != FONT_HEADER_SIZE + data.number_of_glyphs * FONT_GLYPH_SIZE )
+    {
+        printf( "Font Load Error: %s has the wrong number o’ glyphs for its size.\n", full_filename );
+        free( file_buffer );
+        return -1;
+    }
+    for ( int glyph = 0; glyph < data.number_of_glyphs; ++glyph )
+    {
+        const unsigned char* entry = &file_buffer[ FONT_HEADER_SIZE + glyph * FONT_GLYPH_SIZE ];
+        data.glyphs[ glyph ] =
+        {
+            { ( float )( read_u16( &entry[ 0 ] ) ), ( float )( read_u16( &entry[ 2 ] ) ), ( float )( read_u16( &entry[ 4 ] ) ), ( float )( read_u16( &entry[ 6 ] ) ) },
+            read_u16( &entry[ 8 ] )
+        };
+    }
+    free( file_buffer );
+
+    data.texture = render_get_texture( name );
+    if ( data.texture < 0 )
+    {
+        return -1;
+    }
+    return number_of_fonts++;
+}
+
+void text_draw( Font font, const char* text, float x, float y, int palette )
+{
+    const TextLayout* layout = text_get_layout( font, text );
+    if ( layout )
+    {
+        render_texture_pieces( fonts[ font ].texture, &cached_pieces[ layout->first_piece ], layout->number_of_pieces, x, y, palette );
+    }
+}
+
+int text_get_width( Font font, const char* text )
+{
+    const TextLayout* layout = text_get_layout( font, text );
+    return ( layout ) ? layout->width : 0;
+}
+
+int text_get_height( Font font, const char* text )
+{
+    const TextLayout* layout = text_get_layout( font, text );
+    return ( layout ) ? layout->height : 0;
+}
+
+int text_get_line_height( Font font )
+{
+    return fonts[ font ].line_height;
+}
+
+Texture text_get_texture( Font font )
+{
+    return fonts[ font ].texture;
+}
+
+Rect text_get_glyph( Font font, int character )
+{
+    const FontData& data = fonts[ font ];
+    const int glyph = character - data.first_character;
+    if ( glyph < 0 || glyph >= data.number_of_glyphs )
+    {
+        return { 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+    return data.glyphs[ glyph ].src;
+}
+
+
+
+//
+//  PRIVATE FUNCTIONS
+//
+///////////////////////////////////////////////////////////
+
+static const TextLayout* text_get_layout( Font font, const char* text )
+{
+    if ( font < 0 || font >= number_of_fonts )
+    {
+        return nullptr;
+    }
+
+    uint64_t hash = FNV_OFFSET_BASIS ^ ( uint64_t )( font );
+    size_t length = 0;
+    for ( ; text[ length ] != '\0'; ++length )
+    {
+        hash = ( hash ^ ( unsigned char )( text[ length ] ) ) * FNV_PRIME;
+    }
+    const uint64_t key = ( hash != 0 ) ? hash : 1;
+
+    for ( int pass = 0; pass < 2; ++pass )
+    {
+        for ( uint64_t probe = 0; probe < TEXT_CACHE_SIZE; ++probe )
+        {
+            TextLayout& layout = text_cache[ ( key + probe ) & ( TEXT_CACHE_SIZE - 1 ) ];
+            if ( layout.key == key )
+            {
+                return &layout;
+            }
+            if ( layout.key != 0 )
+            {
+                continue;
+            }
+
+            // Keep the table under ¾ full so probes stay short.
+            if ( number_of_cached_layouts >= TEXT_CACHE_SIZE * 3 / 4 || number_of_cached_pieces + length > TEXT_CACHE_PIECES )
+            {
+                break;
+            }
+            layout.key = key;
+            text_build_layout( fonts[ font ], text, layout );
+            ++number_of_cached_layouts;
+            return &layout;
+        }
+        text_clear_cache();
+    }
+    return nullptr; // Longer than the whole cache.
+}
+
+// Spaces & characters the font doesn’t have take up room but get no piece.
+static void text_build_layout( const FontData& data, const char* text, TextLayout& layout )
+{
+    layout.first_piece = number_of_cached_pieces;
+    layout.width = 0;
+    int pen_x = 0;
+    int pen_y = 0;
+    for ( const char* c = text; *c != '\0'; ++c )
+    {
+        if ( *c == '\n' )
+        {
+            layout.width = std::max( layout.width, pen_x );
+            pen_x = 0;
+            pen_y += data.line_height;
+            continue;
+        }
+        const int glyph = ( unsigned char )( *c ) - data.first_character;
+        if ( glyph < 0 || glyph >= data.number_of_glyphs )
+        {
+            continue;
+        }
+        const FontGlyph& font_glyph = data.glyphs[ glyph ];
+        if ( *c != ' ' )
+        {
+            cached_pieces[ number_of_cached_pieces++ ] = { font_glyph.src, ( float )( pen_x ), ( float )( pen_y ) };
+        }
+        pen_x += font_glyph.advance;
+    }
+    layout.width = std::max( layout.width, pen_x );
+    layout.height = pen_y + data.line_height;
+    layout.number_of_pieces = number_of_cached_pieces - layout.first_piece;
+}
+
+static void text_clear_cache()
+{
+    for ( TextLayout& layout : text_cache )
+    {
+        layout.key = 0;
+    }
+    number_of_cached_layouts = 0;
+    number_of_cached_pieces = 0;
+}
+
+static unsigned char* text_read_file( const char* filename, long* file_size )
+{
+    FILE* file = fopen( filename, "rb" );
+    if ( !file )
+    {
+        printf( "File didn’t load: %s\n", filename );
+        return nullptr;
+    }
+
+    fseek( file, 0, SEEK_END );
+    *file_size = ftell( file );
+    rewind( file );
+    unsigned char* file_buffer = ( unsigned char* )( malloc( sizeof( unsigned char ) * *file_size ) );
+    if ( !file_buffer )
+    {
+        printf( "Somehow run out o’ memory for loading file %s\n", filename );
+        fclose( file );
+        return nullptr;
+    }
+    if ( ( long )( fread( file_buffer, 1, *file_size, file ) ) != *file_size )
+    {
+        printf( "Couldn’t read all o’ file %s\n", filename );
+        free( file_buffer );
+        fclose( file );
+        return nullptr;
+    }
+    fclose( file );
+    return file_buffer;
+}
+
+static int read_u16( const unsigned char* data )
+{
+    return ( ( unsigned int )( data[ 0 ] ) << 8 ) | data[ 1 ];
+}